@@ -0,0 +1,475 @@
+/**
+ * @file ColumnarFile.h
+ * @brief Writer and reader for flat binary files of compressed column chunks
+ */
+
+#ifndef HPSSIM_COLUMNARFILE_H_
+#define HPSSIM_COLUMNARFILE_H_
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @class ColumnarFormat
+ * @brief Constants and helpers shared by the columnar writer and reader
+ *
+ * @note
+ * A file starts with the file magic and is followed by chunks of events.
+ * Each chunk starts with the chunk marker, the number of events and the number
+ * of columns, followed by the columns.  A column has its name, its type code,
+ * its compression flag, its raw and stored lengths in bytes and its data.
+ * Columns are named "collection.field" and every collection of a chunk has a
+ * "collection._offsets" column with the first row of each event and the total
+ * row count.  The file ends with the chunk index, which lists the file offset,
+ * first event and number of events of every chunk, followed by the number of
+ * chunks, the offset of the index and the index magic.  All numbers are written
+ * in the byte order of the host, which is little-endian on all supported machines.
+ */
+struct ColumnarFormat {
+
+    static constexpr const char* FILE_MAGIC = "HPSCOLV1";
+    static constexpr const char* INDEX_MAGIC = "HPSCIDX1";
+    static const uint32_t CHUNK_MARKER = 0x4b4e4843;
+
+    /** Suffix of the column with the event offsets of a collection. */
+    static constexpr const char* OFFSETS = "._offsets";
+
+    template<class T> static char typeCode();
+};
+
+template<> inline char ColumnarFormat::typeCode<float>() {
+    return 'f';
+}
+
+template<> inline char ColumnarFormat::typeCode<double>() {
+    return 'd';
+}
+
+template<> inline char ColumnarFormat::typeCode<int32_t>() {
+    return 'i';
+}
+
+template<> inline char ColumnarFormat::typeCode<int64_t>() {
+    return 'l';
+}
+
+template<> inline char ColumnarFormat::typeCode<uint64_t>() {
+    return 'L';
+}
+
+/**
+ * @class ColumnarWriter
+ * @brief Writes the rows of named collections into compressed column chunks
+ *
+ * @note
+ * Values are filled per collection and field and the event is closed by calling
+ * endEvent().  All fields of a collection should be filled once per row.  Fields
+ * or collections which first appear in the middle of a chunk are padded with zeros
+ * for the earlier rows.
+ */
+class ColumnarWriter {
+
+    public:
+
+        virtual ~ColumnarWriter() {
+            if (out_.is_open()) {
+                close();
+            }
+        }
+
+        /**
+         * Set the number of events per chunk.
+         */
+        void setChunkEvents(int chunkEvents) {
+            chunkEvents_ = chunkEvents > 0 ? chunkEvents : 1;
+        }
+
+        /**
+         * Set the zlib compression level of the chunks, or zero to store them uncompressed.
+         */
+        void setCompressionLevel(int compressionLevel) {
+            compressionLevel_ = compressionLevel;
+        }
+
+        void open(const std::string& fileName) {
+            out_.open(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!out_.is_open()) {
+                throw std::runtime_error("Failed to open columnar file " + fileName);
+            }
+            out_.write(ColumnarFormat::FILE_MAGIC, 8);
+            chunks_.clear();
+            nEvents_ = 0;
+            chunkFirstEvent_ = 0;
+            chunkEventCount_ = 0;
+        }
+
+        /**
+         * Append a value to a field of a collection in the current event.
+         */
+        template<class T>
+        void fill(const std::string& collName, const std::string& field, T value) {
+            Column& column = getColumn(collName, field, ColumnarFormat::typeCode<T>(), sizeof(T));
+            size_t pos = column.data.size();
+            column.data.resize(pos + sizeof(T));
+            std::memcpy(column.data.data() + pos, &value, sizeof(T));
+        }
+
+        /**
+         * Make sure a collection is written even if it has no rows.
+         */
+        void addCollection(const std::string& collName) {
+            getCollection(collName);
+        }
+
+        /**
+         * Close the current event and write the chunk if it is full.
+         */
+        void endEvent() {
+            for (auto& entry : collections_) {
+                Collection& coll = entry.second;
+                uint64_t rows = 0;
+                for (auto& column : coll.columns) {
+                    rows = std::max(rows, (uint64_t) (column.second.data.size() / column.second.size));
+                }
+                coll.rows = rows;
+                coll.offsets.push_back(rows);
+            }
+            ++nEvents_;
+            if (++chunkEventCount_ >= chunkEvents_) {
+                writeChunk();
+            }
+        }
+
+        /**
+         * Write the last chunk and the chunk index and close the file.
+         */
+        void close() {
+            if (chunkEventCount_ > 0) {
+                writeChunk();
+            }
+            uint64_t indexOffset = out_.tellp();
+            for (auto& chunk : chunks_) {
+                write(chunk.offset);
+                write(chunk.firstEvent);
+                write(chunk.nEvents);
+            }
+            write((uint32_t) chunks_.size());
+            write(indexOffset);
+            out_.write(ColumnarFormat::INDEX_MAGIC, 8);
+            out_.close();
+            collections_.clear();
+        }
+
+        uint64_t getNumberOfEvents() const {
+            return nEvents_;
+        }
+
+        bool isOpen() const {
+            return out_.is_open();
+        }
+
+    private:
+
+        struct Column {
+            char type;
+            size_t size;
+            std::vector<char> data;
+        };
+
+        struct Collection {
+            /** First row of each event of the chunk followed by the row count. */
+            std::vector<uint64_t> offsets;
+            uint64_t rows{0};
+            std::map<std::string, Column> columns;
+        };
+
+        struct ChunkEntry {
+            uint64_t offset;
+            uint64_t firstEvent;
+            uint32_t nEvents;
+        };
+
+        Collection& getCollection(const std::string& collName) {
+            auto it = collections_.find(collName);
+            if (it == collections_.end()) {
+                it = collections_.insert(std::make_pair(collName, Collection())).first;
+                it->second.offsets.assign(chunkEventCount_ + 1, 0);
+            }
+            return it->second;
+        }
+
+        Column& getColumn(const std::string& collName, const std::string& field, char type, size_t size) {
+            Collection& coll = getCollection(collName);
+            auto it = coll.columns.find(field);
+            if (it == coll.columns.end()) {
+                it = coll.columns.insert(std::make_pair(field, Column{type, size, {}})).first;
+                it->second.data.assign(coll.rows * size, 0);
+            } else if (it->second.type != type) {
+                throw std::runtime_error("Wrong type for column " + collName + "." + field);
+            }
+            return it->second;
+        }
+
+        void writeChunk() {
+            uint32_t nColumns = 0;
+            for (auto& entry : collections_) {
+                nColumns += entry.second.columns.size() + 1;
+            }
+            chunks_.push_back({(uint64_t) out_.tellp(), chunkFirstEvent_, chunkEventCount_});
+            write(ColumnarFormat::CHUNK_MARKER);
+            write(chunkEventCount_);
+            write(nColumns);
+            for (auto& entry : collections_) {
+                Collection& coll = entry.second;
+                writeColumn(entry.first + ColumnarFormat::OFFSETS, ColumnarFormat::typeCode<uint64_t>(),
+                        (const char*) coll.offsets.data(), coll.offsets.size() * sizeof(uint64_t));
+                for (auto& column : coll.columns) {
+                    writeColumn(entry.first + "." + column.first, column.second.type,
+                            column.second.data.data(), column.second.data.size());
+                    column.second.data.clear();
+                }
+                coll.offsets.assign(1, 0);
+                coll.rows = 0;
+            }
+            chunkFirstEvent_ += chunkEventCount_;
+            chunkEventCount_ = 0;
+        }
+
+        void writeColumn(const std::string& name, char type, const char* data, uint64_t rawLength) {
+            write((uint16_t) name.size());
+            out_.write(name.data(), name.size());
+            out_.put(type);
+            const char* stored = data;
+            uint64_t storedLength = rawLength;
+            bool compressed = compressionLevel_ > 0 && rawLength > 0;
+            if (compressed) {
+                uLongf destLen = compressBound(rawLength);
+                buffer_.resize(destLen);
+                if (compress2((Bytef*) buffer_.data(), &destLen, (const Bytef*) data, rawLength,
+                        compressionLevel_) != Z_OK) {
+                    throw std::runtime_error("Failed to compress column " + name);
+                }
+                stored = buffer_.data();
+                storedLength = destLen;
+            }
+            out_.put(compressed ? 1 : 0);
+            write(rawLength);
+            write(storedLength);
+            out_.write(stored, storedLength);
+        }
+
+        template<class T>
+        void write(T value) {
+            out_.write((const char*) &value, sizeof(T));
+        }
+
+    private:
+
+        std::ofstream out_;
+        uint32_t chunkEvents_{1000};
+        int compressionLevel_{Z_DEFAULT_COMPRESSION};
+        uint64_t nEvents_{0};
+        uint64_t chunkFirstEvent_{0};
+        uint32_t chunkEventCount_{0};
+        std::map<std::string, Collection> collections_;
+        std::vector<ChunkEntry> chunks_;
+        std::vector<char> buffer_;
+};
+
+/**
+ * @class ColumnarReader
+ * @brief Reads the chunks of a columnar file and gives typed access to their columns
+ *
+ * @note
+ * Chunks are located with the index at the end of the file, so any chunk can be
+ * read directly.  The column arrays of the current chunk stay valid until the next
+ * chunk is read.
+ */
+class ColumnarReader {
+
+    public:
+
+        void open(const std::string& fileName) {
+            in_.open(fileName.c_str(), std::ios::in | std::ios::binary);
+            if (!in_.is_open()) {
+                throw std::runtime_error("Failed to open columnar file " + fileName);
+            }
+            char magic[8];
+            if (!in_.read(magic, 8) || std::strncmp(magic, ColumnarFormat::FILE_MAGIC, 8)) {
+                throw std::runtime_error("Not a columnar file: " + fileName);
+            }
+            in_.seekg(-20, std::ios::end);
+            uint32_t nChunks = read<uint32_t>();
+            uint64_t indexOffset = read<uint64_t>();
+            if (!in_.read(magic, 8) || std::strncmp(magic, ColumnarFormat::INDEX_MAGIC, 8)) {
+                throw std::runtime_error("Missing chunk index in columnar file: " + fileName);
+            }
+            in_.seekg(indexOffset);
+            chunks_.resize(nChunks);
+            for (auto& chunk : chunks_) {
+                chunk.offset = read<uint64_t>();
+                chunk.firstEvent = read<uint64_t>();
+                chunk.nEvents = read<uint32_t>();
+            }
+            current_ = -1;
+        }
+
+        void close() {
+            in_.close();
+            columns_.clear();
+        }
+
+        size_t getNumberOfChunks() const {
+            return chunks_.size();
+        }
+
+        uint64_t getNumberOfEvents() const {
+            return chunks_.empty() ? 0 : chunks_.back().firstEvent + chunks_.back().nEvents;
+        }
+
+        uint64_t getChunkFirstEvent() const {
+            return chunks_[current_].firstEvent;
+        }
+
+        uint32_t getChunkEvents() const {
+            return chunks_[current_].nEvents;
+        }
+
+        /**
+         * Find the chunk which contains an event.
+         */
+        int findChunk(uint64_t event) const {
+            for (size_t i = 0; i < chunks_.size(); i++) {
+                if (event < chunks_[i].firstEvent + chunks_[i].nEvents) {
+                    return i;
+                }
+            }
+            return -1;
+        }
+
+        /**
+         * Read and decompress all columns of a chunk.
+         */
+        void readChunk(int chunk) {
+            columns_.clear();
+            in_.clear();
+            in_.seekg(chunks_[chunk].offset);
+            if (read<uint32_t>() != ColumnarFormat::CHUNK_MARKER) {
+                throw std::runtime_error("Bad chunk marker in columnar file");
+            }
+            read<uint32_t>();
+            uint32_t nColumns = read<uint32_t>();
+            for (uint32_t i = 0; i < nColumns; i++) {
+                std::string name(read<uint16_t>(), ' ');
+                in_.read(&name[0], name.size());
+                Column& column = columns_[name];
+                column.type = in_.get();
+                bool compressed = in_.get();
+                uint64_t rawLength = read<uint64_t>();
+                uint64_t storedLength = read<uint64_t>();
+                column.data.resize(rawLength);
+                if (compressed) {
+                    buffer_.resize(storedLength);
+                    in_.read(buffer_.data(), storedLength);
+                    uLongf destLen = rawLength;
+                    if (uncompress((Bytef*) column.data.data(), &destLen, (const Bytef*) buffer_.data(),
+                            storedLength) != Z_OK || destLen != rawLength) {
+                        throw std::runtime_error("Failed to uncompress column " + name);
+                    }
+                } else {
+                    in_.read(column.data.data(), rawLength);
+                }
+                if (!in_) {
+                    throw std::runtime_error("Truncated column " + name);
+                }
+            }
+            current_ = chunk;
+        }
+
+        /**
+         * Get the names of the columns of the current chunk.
+         */
+        std::vector<std::string> getColumnNames() const {
+            std::vector<std::string> names;
+            for (auto& entry : columns_) {
+                names.push_back(entry.first);
+            }
+            return names;
+        }
+
+        /**
+         * Get a column of the current chunk, or null if the chunk does not have it.
+         * @param nRows Set to the number of rows of the column.
+         */
+        template<class T>
+        const T* getColumn(const std::string& name, size_t& nRows) const {
+            auto it = columns_.find(name);
+            if (it == columns_.end()) {
+                nRows = 0;
+                return nullptr;
+            }
+            if (it->second.type != ColumnarFormat::typeCode<T>()) {
+                throw std::runtime_error("Wrong type for column " + name);
+            }
+            nRows = it->second.data.size() / sizeof(T);
+            return (const T*) it->second.data.data();
+        }
+
+        /**
+         * Get the rows [begin, end) of a collection for an event of the current chunk.
+         * @return False if the collection is not in the chunk.
+         */
+        bool getEventRows(const std::string& collName, uint32_t chunkEvent, uint64_t& begin, uint64_t& end) const {
+            size_t n;
+            const uint64_t* offsets = getColumn<uint64_t>(collName + ColumnarFormat::OFFSETS, n);
+            if (!offsets || chunkEvent + 1 >= n) {
+                begin = end = 0;
+                return false;
+            }
+            begin = offsets[chunkEvent];
+            end = offsets[chunkEvent + 1];
+            return true;
+        }
+
+    private:
+
+        struct Column {
+            char type;
+            std::vector<char> data;
+        };
+
+        struct ChunkEntry {
+            uint64_t offset;
+            uint64_t firstEvent;
+            uint32_t nEvents;
+        };
+
+        template<class T>
+        T read() {
+            T value;
+            in_.read((char*) &value, sizeof(T));
+            return value;
+        }
+
+    private:
+
+        std::ifstream in_;
+        std::vector<ChunkEntry> chunks_;
+        int current_{-1};
+        std::map<std::string, Column> columns_;
+        std::vector<char> buffer_;
+};
+
+}
+
+#endif
@@ -0,0 +1,338 @@
+#ifndef HPSSIM_COLUMNAROUTPUT_H_
+#define HPSSIM_COLUMNAROUTPUT_H_
+
+/*
+ * LCDD
+ */
+#include "lcdd/hits/CalorimeterHit.hh"
+#include "lcdd/hits/TrackerHit.hh"
+
+/*
+ * Geant4
+ */
+#include "G4Event.hh"
+#include "G4Run.hh"
+#include "G4RunManager.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4SystemOfUnits.hh"
+
+/*
+ * C++
+ */
+#include <algorithm>
+#include <cfloat>
+#include <unordered_map>
+
+/*
+ * HPS
+ */
+#include "ColumnarFile.h"
+#include "ColumnarOutputMessenger.h"
+#include "MCParticleBuilder.h"
+
+namespace hpssim {
+
+/**
+ * @class ColumnarOutput
+ * @brief Writes Geant4 events to a columnar file instead of LCIO
+ *
+ * @note
+ * The MCParticles and hits are written as typed columns so that analysis can read
+ * single fields without deserializing whole events.  The MCParticle collection is
+ * named "MCParticle" and each hits collection keeps its Geant4 name.  Calorimeter
+ * hit contributions are written to a separate "<name>Contributions" collection.
+ * References between collections are row numbers within the same event.  The units
+ * are the same as in the LCIO output (mm, GeV and ns).
+ *
+ * This output is owned by the LcioPersistencyManager, which receives the events
+ * from Geant4 and passes the ones accepted by its filters to this output instead
+ * of writing LCIO when it is selected with the /hps/output/format command.
+ * The file stays open over runs and is closed when the output is deleted, so
+ * the events of all runs of the job are in the same file unless the file name
+ * is changed between runs.
+ *
+ * @see ColumnarFile.h
+ */
+class ColumnarOutput {
+
+    public:
+
+        ColumnarOutput() {
+            messenger_ = new ColumnarOutputMessenger(this);
+        }
+
+        virtual ~ColumnarOutput() {
+            close();
+            delete messenger_;
+        }
+
+        /**
+         * Set whether events are written to this output instead of LCIO.
+         */
+        void setEnabled(bool enabled) {
+            enabled_ = enabled;
+        }
+
+        bool isEnabled() {
+            return enabled_;
+        }
+
+        void setVerbose(int verbose) {
+            verbose_ = verbose;
+        }
+
+        /**
+         * Open the output file at the beginning of the run, unless it was opened
+         * already by a previous run, in which case the events are appended to it.
+         */
+        void open() {
+            if (writer_.isOpen() && openFile_ == outputFile_) {
+                return;
+            }
+            close();
+            if (verbose_ > 1) {
+                std::cout << "ColumnarOutput: Opening '" << outputFile_ << "'" << std::endl;
+            }
+            writer_.setChunkEvents(chunkEvents_);
+            writer_.setCompressionLevel(compressionLevel_);
+            try {
+                writer_.open(outputFile_);
+                openFile_ = outputFile_;
+            } catch (std::exception& e) {
+                G4Exception("ColumnarOutput::open()", "", RunMustBeAborted, e.what());
+            }
+            nRunEvents_ = 0;
+        }
+
+        /**
+         * Write the MCParticles and hits collections of a Geant4 event.
+         */
+        void write(const G4Event* anEvent, MCParticleBuilder* builder) {
+            if (verbose_ > 1) {
+                std::cout << "ColumnarOutput: Writing event " << anEvent->GetEventID() << std::endl;
+            }
+
+            writeEventHeader(anEvent);
+
+            auto particleColl = builder->buildMCParticleColl(anEvent);
+            if (builder->isPrune()) {
+                markHitTracks(anEvent, builder);
+                builder->prune(particleColl);
+            }
+            builder->resolveAncestors();
+            writeMCParticles(particleColl);
+
+            G4HCofThisEvent* hce = anEvent->GetHCofThisEvent();
+            if (hce) {
+                for (int i = 0; i < hce->GetNumberOfCollections(); i++) {
+                    G4VHitsCollection* hc = hce->GetHC(i);
+                    if (auto trackerHits = dynamic_cast<TrackerHitsCollection*>(hc)) {
+                        writeTrackerHits(hc->GetName(), trackerHits, builder);
+                    } else if (auto calHits = dynamic_cast<CalorimeterHitsCollection*>(hc)) {
+                        writeCalorimeterHits(hc->GetName(), calHits, builder);
+                    }
+                }
+            }
+
+            writer_.endEvent();
+
+            // The MCParticles were only needed to fill the columns.
+            if (builder->hasObjectPool()) {
+                particleColl->clear();
+            }
+            delete particleColl;
+            particleRows_.clear();
+
+            ++nRunEvents_;
+        }
+
+        /**
+         * Print the number of events written in the run, which stay in the open file.
+         */
+        void endRun(const G4Run* aRun) {
+            if (verbose_ > 0) {
+                std::cout << "ColumnarOutput: Wrote " << nRunEvents_ << " events in run " << aRun->GetRunID()
+                        << " to '" << openFile_ << "'" << std::endl;
+            }
+            nRunEvents_ = 0;
+        }
+
+        /**
+         * Write the chunk index and close the output file if it is open.
+         */
+        void close() {
+            if (!writer_.isOpen()) {
+                return;
+            }
+            writer_.close();
+            if (verbose_ > 0) {
+                std::cout << "ColumnarOutput: Wrote " << writer_.getNumberOfEvents()
+                        << " events to '" << openFile_ << "'" << std::endl;
+            }
+        }
+
+        void setOutputFile(std::string outputFile) {
+            outputFile_ = outputFile;
+        }
+
+        /**
+         * Set the number of events per column chunk.
+         */
+        void setChunkEvents(int chunkEvents) {
+            chunkEvents_ = chunkEvents;
+        }
+
+        /**
+         * Set the zlib compression level of the column chunks, or zero for no compression.
+         */
+        void setCompressionLevel(int compressionLevel) {
+            compressionLevel_ = compressionLevel;
+        }
+
+    private:
+
+        void writeEventHeader(const G4Event* anEvent) {
+            writer_.fill<int32_t>("Event", "run", G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID());
+            writer_.fill<int32_t>("Event", "event", anEvent->GetEventID());
+            float weight = anEvent->GetPrimaryVertex() ? anEvent->GetPrimaryVertex()->GetWeight() : 1;
+            writer_.fill<float>("Event", "weight", weight);
+        }
+
+        /**
+         * Mark the tracks referenced by the hits for pruning the MCParticles.
+         */
+        void markHitTracks(const G4Event* anEvent, MCParticleBuilder* builder) {
+            G4HCofThisEvent* hce = anEvent->GetHCofThisEvent();
+            if (!hce) {
+                return;
+            }
+            for (int i = 0; i < hce->GetNumberOfCollections(); i++) {
+                G4VHitsCollection* hc = hce->GetHC(i);
+                if (auto trackerHits = dynamic_cast<TrackerHitsCollection*>(hc)) {
+                    for (int j = 0; j < (int) trackerHits->GetSize(); j++) {
+                        builder->markReferenced(static_cast<TrackerHit*>(trackerHits->GetHit(j))->getTrackID());
+                    }
+                } else if (auto calHits = dynamic_cast<CalorimeterHitsCollection*>(hc)) {
+                    for (int j = 0; j < (int) calHits->GetSize(); j++) {
+                        for (const auto& contrib : static_cast<CalorimeterHit*>(calHits->GetHit(j))->getHitContributions()) {
+                            builder->markReferenced(contrib.getTrackID());
+                        }
+                    }
+                }
+            }
+        }
+
+        void writeMCParticles(IMPL::LCCollectionVec* particleColl) {
+            const std::string collName = "MCParticle";
+            writer_.addCollection(collName);
+            for (int i = 0; i < (int) particleColl->size(); i++) {
+                particleRows_[static_cast<EVENT::MCParticle*>(particleColl->at(i))] = i;
+            }
+            for (auto object : *particleColl) {
+                auto particle = static_cast<EVENT::MCParticle*>(object);
+                const double* p = particle->getMomentum();
+                const double* vertex = particle->getVertex();
+                const double* endpoint = particle->getEndpoint();
+                const auto& parents = particle->getParents();
+                writer_.fill<int32_t>(collName, "pdg", particle->getPDG());
+                writer_.fill<int32_t>(collName, "generatorStatus", particle->getGeneratorStatus());
+                writer_.fill<int32_t>(collName, "simulatorStatus", particle->getSimulatorStatus());
+                writer_.fill<int32_t>(collName, "parent", parents.size() ? getParticleRow(parents[0]) : -1);
+                writer_.fill<float>(collName, "charge", particle->getCharge());
+                writer_.fill<float>(collName, "mass", particle->getMass());
+                writer_.fill<float>(collName, "energy", particle->getEnergy());
+                writer_.fill<float>(collName, "px", p[0]);
+                writer_.fill<float>(collName, "py", p[1]);
+                writer_.fill<float>(collName, "pz", p[2]);
+                writer_.fill<float>(collName, "vx", vertex[0]);
+                writer_.fill<float>(collName, "vy", vertex[1]);
+                writer_.fill<float>(collName, "vz", vertex[2]);
+                writer_.fill<float>(collName, "ex", endpoint[0]);
+                writer_.fill<float>(collName, "ey", endpoint[1]);
+                writer_.fill<float>(collName, "ez", endpoint[2]);
+                writer_.fill<float>(collName, "time", particle->getTime());
+            }
+        }
+
+        void writeTrackerHits(const std::string& collName, TrackerHitsCollection* trackerHits, MCParticleBuilder* builder) {
+            writer_.addCollection(collName);
+            for (int i = 0; i < (int) trackerHits->GetSize(); i++) {
+                auto hit = static_cast<TrackerHit*>(trackerHits->GetHit(i));
+                const G4ThreeVector pos = hit->getPosition();
+                const G4ThreeVector& p = hit->getMomentum();
+                writer_.fill<int64_t>(collName, "cellID", hit->getId());
+                writer_.fill<float>(collName, "x", pos.x());
+                writer_.fill<float>(collName, "y", pos.y());
+                writer_.fill<float>(collName, "z", pos.z());
+                writer_.fill<float>(collName, "px", p.x() / GeV);
+                writer_.fill<float>(collName, "py", p.y() / GeV);
+                writer_.fill<float>(collName, "pz", p.z() / GeV);
+                writer_.fill<float>(collName, "pathLength", hit->getLength());
+                writer_.fill<float>(collName, "edep", hit->getEdep() / GeV);
+                writer_.fill<float>(collName, "time", hit->getTdep());
+                writer_.fill<int32_t>(collName, "mcParticle", getParticleRow(builder->getMCParticle(hit->getTrackID())));
+            }
+        }
+
+        void writeCalorimeterHits(const std::string& collName, CalorimeterHitsCollection* calHits, MCParticleBuilder* builder) {
+            const std::string contribCollName = collName + "Contributions";
+            writer_.addCollection(collName);
+            writer_.addCollection(contribCollName);
+            for (int i = 0; i < (int) calHits->GetSize(); i++) {
+                auto hit = static_cast<CalorimeterHit*>(calHits->GetHit(i));
+                const G4ThreeVector pos = hit->getPosition();
+                double time = DBL_MAX;
+                for (const auto& contrib : hit->getHitContributions()) {
+                    time = std::min(time, (double) contrib.getGlobalTime());
+                    writer_.fill<int32_t>(contribCollName, "hit", i);
+                    writer_.fill<int32_t>(contribCollName, "mcParticle",
+                            getParticleRow(builder->getMCParticle(contrib.getTrackID())));
+                    writer_.fill<int32_t>(contribCollName, "pdg", contrib.getPDGID());
+                    writer_.fill<float>(contribCollName, "energy", contrib.getEdep() / GeV);
+                    writer_.fill<float>(contribCollName, "time", contrib.getGlobalTime());
+                }
+                const Id64bit& id64 = hit->getId64bit();
+                writer_.fill<int64_t>(collName, "cellID", ((int64_t) id64.getId1() << 32) | (uint32_t) id64.getId0());
+                writer_.fill<float>(collName, "x", pos.x());
+                writer_.fill<float>(collName, "y", pos.y());
+                writer_.fill<float>(collName, "z", pos.z());
+                writer_.fill<float>(collName, "energy", hit->getEdep() / GeV);
+                writer_.fill<float>(collName, "time", time == DBL_MAX ? 0 : time);
+            }
+        }
+
+        /**
+         * Get the row of an MCParticle in the current event, or -1 if it was not written.
+         */
+        int32_t getParticleRow(EVENT::MCParticle* particle) {
+            auto it = particleRows_.find(particle);
+            return it != particleRows_.end() ? it->second : -1;
+        }
+
+    private:
+
+        ColumnarOutputMessenger* messenger_;
+
+        ColumnarWriter writer_;
+
+        bool enabled_{false};
+        int verbose_{1};
+
+        std::string outputFile_{"hps_sim_events.col"};
+
+        /** Name of the file which is currently open. */
+        std::string openFile_;
+
+        /** Number of events written in the current run. */
+        long nRunEvents_{0};
+
+        int chunkEvents_{1000};
+        int compressionLevel_{1};
+
+        /** Row of each MCParticle of the current event. */
+        std::unordered_map<EVENT::MCParticle*, int32_t> particleRows_;
+};
+
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef HPSSIM_COLUMNAROUTPUTMESSENGER_H_
+#define HPSSIM_COLUMNAROUTPUTMESSENGER_H_
+
+#include "G4UImessenger.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+namespace hpssim {
+
+class ColumnarOutput;
+
+class ColumnarOutputMessenger : public G4UImessenger {
+
+    public:
+
+        ColumnarOutputMessenger(ColumnarOutput* output);
+
+        void SetNewValue(G4UIcommand* command, G4String newValues);
+
+    private:
+
+        ColumnarOutput* output_;
+
+        /* Output format selection. */
+        G4UIdirectory* outputDir_;
+        G4UIcmdWithAString* formatCmd_;
+
+        /*
+         * Columnar output commands.
+         */
+        G4UIdirectory* columnarDir_;
+        G4UIcmdWithAString* fileCmd_;
+        G4UIcmdWithAnInteger* verboseCmd_;
+        G4UIcmdWithAnInteger* chunkEventsCmd_;
+        G4UIcmdWithAnInteger* compressionCmd_;
+};
+
+}
+
+#endif
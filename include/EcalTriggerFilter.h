@@ -0,0 +1,318 @@
+#ifndef HPSSIM_ECALTRIGGERFILTER_H_
+#define HPSSIM_ECALTRIGGERFILTER_H_
+
+/*
+ * Geant4
+ */
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+/*
+ * C++
+ */
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+/*
+ * HPS
+ */
+#include "EcalTriggerMessenger.h"
+#include "StoreFilter.h"
+
+namespace hpssim {
+
+/**
+ * @class EcalTriggerFilter
+ * @brief Emulates the ECal trigger on the Geant4 calorimeter hits and rejects untriggered events
+ *
+ * @note
+ * Clusters are built around seed hits, which are hits above the seed threshold
+ * with the highest energy among their 3x3 neighbours.  The cluster energy is the
+ * sum of the seed and its neighbours above the hit threshold.  Neighbours are found
+ * from the hit positions using the crystal pitch instead of the crystal indices.
+ * The singles trigger fires on one cluster passing the cluster cuts and the pair
+ * trigger on a top and bottom cluster which also pass the pair cuts.  A prescaled
+ * sample of rejected events can be kept for validation.  The filter accepts every
+ * event until it is enabled.
+ */
+class EcalTriggerFilter : public HitsCollectionFilter {
+
+    public:
+
+        /** The trigger type. */
+        enum TriggerMode {
+            /** One cluster passing the cluster cuts. */
+            SINGLES,
+            /** A top and bottom cluster passing the cluster and pair cuts. */
+            PAIR
+        };
+
+        /** Trigger cluster made of a seed hit and its neighbours. */
+        struct Cluster {
+            double energy;
+            double x;
+            double y;
+            double time;
+            int nHits;
+        };
+
+        EcalTriggerFilter() : HitsCollectionFilter("EcalHits") {
+            messenger_ = new EcalTriggerMessenger(this);
+        }
+
+        virtual ~EcalTriggerFilter() {
+            delete messenger_;
+        }
+
+        void initialize() {
+            HitsCollectionFilter::initialize();
+            nTriggered_ = 0;
+            nRejected_ = 0;
+            nPrescaled_ = 0;
+        }
+
+        bool accept(const G4Event* anEvent) {
+            if (!enabled_) {
+                return true;
+            }
+            auto calHits = dynamic_cast<CalorimeterHitsCollection*>(getHitsCollection(anEvent));
+            bool triggered = false;
+            if (calHits) {
+                findClusters(calHits);
+                triggered = mode_ == SINGLES ? clusters_.size() > 0 : isPairTriggered();
+            }
+            if (verbose_ > 1) {
+                std::cout << "EcalTriggerFilter: Event " << anEvent->GetEventID() << " has " << clusters_.size()
+                        << " trigger clusters and was " << (triggered ? "" : "not ") << "triggered" << std::endl;
+            }
+            if (triggered) {
+                ++nTriggered_;
+                return true;
+            }
+            ++nRejected_;
+            if (prescale_ > 0 && nRejected_ % prescale_ == 0) {
+                ++nPrescaled_;
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * Print the trigger counts of the current run.
+         */
+        void printSummary() {
+            if (enabled_) {
+                std::cout << "EcalTriggerFilter: Triggered " << nTriggered_ << " events and kept "
+                        << nPrescaled_ << " of " << nRejected_ << " rejected events" << std::endl;
+            }
+        }
+
+        void setEnabled(bool enabled) {
+            enabled_ = enabled;
+        }
+
+        void setVerbose(int verbose) {
+            verbose_ = verbose;
+        }
+
+        void setCollectionName(std::string collName) {
+            collName_ = collName;
+            collID_ = -2;
+        }
+
+        void setTriggerMode(TriggerMode mode) {
+            mode_ = mode;
+        }
+
+        void setHitThreshold(double hitThreshold) {
+            hitThreshold_ = hitThreshold;
+        }
+
+        void setSeedThreshold(double seedThreshold) {
+            seedThreshold_ = seedThreshold;
+        }
+
+        /**
+         * Set the distance between crystal centers which is used to find neighbouring hits.
+         * The default is the 13.3 mm front face pitch of the HPS ECal crystals.
+         */
+        void setCrystalPitch(double crystalPitch) {
+            crystalPitch_ = crystalPitch;
+        }
+
+        void setClusterEnergyMin(double clusterEnergyMin) {
+            clusterEnergyMin_ = clusterEnergyMin;
+        }
+
+        void setClusterEnergyMax(double clusterEnergyMax) {
+            clusterEnergyMax_ = clusterEnergyMax;
+        }
+
+        void setClusterHitsMin(int clusterHitsMin) {
+            clusterHitsMin_ = clusterHitsMin;
+        }
+
+        void setPairEnergySumMin(double pairEnergySumMin) {
+            pairEnergySumMin_ = pairEnergySumMin;
+        }
+
+        void setPairEnergySumMax(double pairEnergySumMax) {
+            pairEnergySumMax_ = pairEnergySumMax;
+        }
+
+        void setPairEnergyDiffMax(double pairEnergyDiffMax) {
+            pairEnergyDiffMax_ = pairEnergyDiffMax;
+        }
+
+        void setPairCoplanarityMax(double pairCoplanarityMax) {
+            pairCoplanarityMax_ = pairCoplanarityMax;
+        }
+
+        /**
+         * Set the maximum time difference of the pair clusters, or zero for no time cut.
+         */
+        void setPairTimeMax(double pairTimeMax) {
+            pairTimeMax_ = pairTimeMax;
+        }
+
+        /**
+         * Keep every Nth rejected event, or none if this is zero.
+         */
+        void setPrescale(int prescale) {
+            prescale_ = prescale;
+        }
+
+    private:
+
+        /** Calorimeter hit above the hit threshold. */
+        struct TriggerHit {
+            double energy;
+            double x;
+            double y;
+            double time;
+        };
+
+        bool isNeighbor(const TriggerHit& hit1, const TriggerHit& hit2) {
+            double window = 1.5 * crystalPitch_;
+            return std::fabs(hit1.x - hit2.x) < window && std::fabs(hit1.y - hit2.y) < window;
+        }
+
+        /**
+         * Find the clusters of the event which pass the cluster cuts.
+         */
+        void findClusters(CalorimeterHitsCollection* calHits) {
+            hits_.clear();
+            clusters_.clear();
+            for (int i = 0; i < (int) calHits->GetSize(); i++) {
+                auto calHit = static_cast<CalorimeterHit*>(calHits->GetHit(i));
+                double energy = calHit->getEdep();
+                if (energy < hitThreshold_) {
+                    continue;
+                }
+                double time = DBL_MAX;
+                for (const auto& contrib : calHit->getHitContributions()) {
+                    time = std::min(time, (double) contrib.getGlobalTime());
+                }
+                const G4ThreeVector& pos = calHit->getPosition();
+                hits_.push_back({energy, pos.x(), pos.y(), time == DBL_MAX ? 0 : time});
+            }
+
+            for (size_t iSeed = 0; iSeed < hits_.size(); iSeed++) {
+                const TriggerHit& seed = hits_[iSeed];
+                if (seed.energy < seedThreshold_) {
+                    continue;
+                }
+                Cluster cluster{0, seed.x, seed.y, seed.time, 0};
+                bool isSeed = true;
+                for (size_t iHit = 0; iHit < hits_.size() && isSeed; iHit++) {
+                    const TriggerHit& hit = hits_[iHit];
+                    if (iHit != iSeed && isNeighbor(seed, hit)) {
+                        // Equal energies are resolved by the hit order so only one of them is a seed.
+                        if (hit.energy > seed.energy || (hit.energy == seed.energy && iHit < iSeed)) {
+                            isSeed = false;
+                        }
+                    }
+                    if (isNeighbor(seed, hit)) {
+                        cluster.energy += hit.energy;
+                        ++cluster.nHits;
+                    }
+                }
+                if (isSeed && cluster.energy >= clusterEnergyMin_ && cluster.energy <= clusterEnergyMax_
+                        && cluster.nHits >= clusterHitsMin_) {
+                    clusters_.push_back(cluster);
+                }
+            }
+        }
+
+        /**
+         * Check for a pair of top and bottom clusters passing the pair cuts.
+         */
+        bool isPairTriggered() {
+            for (const auto& top : clusters_) {
+                if (top.y <= 0) {
+                    continue;
+                }
+                for (const auto& bottom : clusters_) {
+                    if (bottom.y >= 0) {
+                        continue;
+                    }
+                    double energySum = top.energy + bottom.energy;
+                    if (energySum < pairEnergySumMin_ || energySum > pairEnergySumMax_) {
+                        continue;
+                    }
+                    if (std::fabs(top.energy - bottom.energy) > pairEnergyDiffMax_) {
+                        continue;
+                    }
+                    // Azimuthal angle between the clusters in [0, pi], which is pi for coplanar clusters.
+                    double dphi = std::fabs(std::remainder(std::atan2(top.y, top.x) - std::atan2(bottom.y, bottom.x), twopi));
+                    if (pi - dphi > pairCoplanarityMax_) {
+                        continue;
+                    }
+                    if (pairTimeMax_ > 0 && std::fabs(top.time - bottom.time) > pairTimeMax_) {
+                        continue;
+                    }
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+
+        EcalTriggerMessenger* messenger_;
+
+        bool enabled_{false};
+        int verbose_{1};
+        TriggerMode mode_{SINGLES};
+
+        double hitThreshold_{7.5 * MeV};
+        double seedThreshold_{50 * MeV};
+        double crystalPitch_{13.3 * mm};
+
+        double clusterEnergyMin_{0};
+        double clusterEnergyMax_{DBL_MAX};
+        int clusterHitsMin_{1};
+
+        double pairEnergySumMin_{0};
+        double pairEnergySumMax_{DBL_MAX};
+        double pairEnergyDiffMax_{DBL_MAX};
+        double pairCoplanarityMax_{180 * deg};
+        double pairTimeMax_{0};
+
+        int prescale_{0};
+
+        long nTriggered_{0};
+        long nRejected_{0};
+        long nPrescaled_{0};
+
+        /** Hits and clusters of the current event, which are reused between events. */
+        std::vector<TriggerHit> hits_;
+        std::vector<Cluster> clusters_;
+};
+
+}
+
+#endif
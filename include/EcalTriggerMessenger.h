@@ -0,0 +1,52 @@
+#ifndef HPSSIM_ECALTRIGGERMESSENGER_H_
+#define HPSSIM_ECALTRIGGERMESSENGER_H_
+
+#include "G4UImessenger.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithABool.hh"
+
+namespace hpssim {
+
+class EcalTriggerFilter;
+
+class EcalTriggerMessenger : public G4UImessenger {
+
+    public:
+
+        EcalTriggerMessenger(EcalTriggerFilter* trigger);
+
+        void SetNewValue(G4UIcommand* command, G4String newValues);
+
+    private:
+
+        EcalTriggerFilter* trigger_;
+
+        G4UIdirectory* triggerDir_;
+
+        G4UIcmdWithABool* enableCmd_;
+        G4UIcmdWithAnInteger* verboseCmd_;
+        G4UIcmdWithAString* collectionCmd_;
+        G4UIcmdWithAString* modeCmd_;
+
+        G4UIcmdWithADoubleAndUnit* hitThresholdCmd_;
+        G4UIcmdWithADoubleAndUnit* seedThresholdCmd_;
+        G4UIcmdWithADoubleAndUnit* crystalPitchCmd_;
+
+        G4UIcmdWithADoubleAndUnit* clusterEnergyMinCmd_;
+        G4UIcmdWithADoubleAndUnit* clusterEnergyMaxCmd_;
+        G4UIcmdWithAnInteger* clusterHitsMinCmd_;
+
+        G4UIcmdWithADoubleAndUnit* pairEnergySumMinCmd_;
+        G4UIcmdWithADoubleAndUnit* pairEnergySumMaxCmd_;
+        G4UIcmdWithADoubleAndUnit* pairEnergyDiffMaxCmd_;
+        G4UIcmdWithADoubleAndUnit* pairCoplanarityMaxCmd_;
+        G4UIcmdWithADoubleAndUnit* pairTimeMaxCmd_;
+
+        G4UIcmdWithAnInteger* prescaleCmd_;
+};
+
+}
+
+#endif
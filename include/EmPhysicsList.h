@@ -0,0 +1,55 @@
+#ifndef HPSSIM_EMPHYSICSLIST_H_
+#define HPSSIM_EMPHYSICSLIST_H_
+
+/*
+ * Geant4
+ */
+#include "G4DecayPhysics.hh"
+#include "G4EmExtraPhysics.hh"
+#include "G4EmStandardPhysics.hh"
+#include "G4EmStandardPhysics_option4.hh"
+#include "G4VModularPhysicsList.hh"
+
+namespace hpssim {
+
+/**
+ * @class EmPhysicsList
+ * @brief Physics list with only electromagnetic physics and decays
+ *
+ * @note
+ * This is meant for beam background, WAB and trident production where hadronic
+ * physics only costs initialization time, memory and process lookups per step.
+ * Gamma-nuclear reactions can be added optionally, and the standard or the
+ * more precise option 4 EM physics constructor can be used.
+ */
+class EmPhysicsList : public G4VModularPhysicsList {
+
+    public:
+
+        /**
+         * @param emOption The standard EM physics option, which is 0 or 4.
+         * @param gammaNuclear True to add gamma-nuclear reactions.
+         */
+        EmPhysicsList(int emOption = 0, bool gammaNuclear = false) {
+            if (emOption == 4) {
+                RegisterPhysics(new G4EmStandardPhysics_option4());
+            } else {
+                RegisterPhysics(new G4EmStandardPhysics());
+            }
+            RegisterPhysics(new G4DecayPhysics());
+            if (gammaNuclear) {
+                auto extraPhysics = new G4EmExtraPhysics();
+                extraPhysics->GammaNuclear(true);
+                extraPhysics->MuonNuclear(false);
+                extraPhysics->Synch(false);
+                RegisterPhysics(extraPhysics);
+            }
+        }
+
+        virtual ~EmPhysicsList() {
+        }
+};
+
+}
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef HPSSIM_LCIOCOLLECTIONSORTER_H_
+#define HPSSIM_LCIOCOLLECTIONSORTER_H_
+
+/*
+ * LCIO
+ */
+#include "EVENT/LCIO.h"
+#include "EVENT/MCParticle.h"
+#include "EVENT/SimCalorimeterHit.h"
+#include "EVENT/SimTrackerHit.h"
+#include "IMPL/LCCollectionVec.h"
+#include "IMPL/LCEventImpl.h"
+
+/*
+ * C++
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_set>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @class LcioCollectionSorter
+ * @brief Orders the objects of output collections for locality before they are written
+ *
+ * @note
+ * Hits are sorted by their 64-bit cell ID and then by time using an LSD radix sort,
+ * so hits of the same cell are next to each other in the file.  MCParticles are put
+ * in depth-first order of their ancestry, so each particle is followed by its decay
+ * and shower products.  Only the order of the objects in the collections changes,
+ * so references between objects remain valid.  The scratch buffers are reused
+ * between events.
+ */
+class LcioCollectionSorter {
+
+    public:
+
+        /**
+         * Sort all hits and MCParticle collections of an event.
+         */
+        void sort(IMPL::LCEventImpl* event) {
+            for (auto& collName : *event->getCollectionNames()) {
+                auto collVec = dynamic_cast<IMPL::LCCollectionVec*>(event->getCollection(collName));
+                if (!collVec || collVec->isSubset() || collVec->size() < 2) {
+                    continue;
+                }
+                const std::string& type = collVec->getTypeName();
+                if (type == EVENT::LCIO::SIMTRACKERHIT || type == EVENT::LCIO::SIMCALORIMETERHIT) {
+                    sortHits(collVec);
+                } else if (type == EVENT::LCIO::MCPARTICLE) {
+                    sortParticles(collVec);
+                }
+            }
+        }
+
+        /**
+         * Sort a SimTrackerHit or SimCalorimeterHit collection by cell ID and time.
+         */
+        void sortHits(IMPL::LCCollectionVec* collVec) {
+            bool tracker = collVec->getTypeName() == EVENT::LCIO::SIMTRACKERHIT;
+            entries_.resize(collVec->size());
+            for (size_t i = 0; i < collVec->size(); i++) {
+                SortEntry& entry = entries_[i];
+                entry.index = i;
+                if (tracker) {
+                    auto hit = static_cast<EVENT::SimTrackerHit*>(collVec->at(i));
+                    entry.cellID = makeCellID(hit->getCellID0(), hit->getCellID1());
+                    entry.time = makeTimeKey(hit->getTime());
+                } else {
+                    auto hit = static_cast<EVENT::SimCalorimeterHit*>(collVec->at(i));
+                    entry.cellID = makeCellID(hit->getCellID0(), hit->getCellID1());
+                    float time = hit->getNMCContributions() ? hit->getTimeCont(0) : 0;
+                    for (int j = 1; j < hit->getNMCContributions(); j++) {
+                        time = std::min(time, hit->getTimeCont(j));
+                    }
+                    entry.time = makeTimeKey(time);
+                }
+            }
+
+            // The least significant key is sorted first: time, then cell ID.
+            for (int shift = 0; shift < 32; shift += 8) {
+                radixPass(shift, false);
+            }
+            for (int shift = 0; shift < 64; shift += 8) {
+                radixPass(shift, true);
+            }
+
+            objects_.assign(collVec->begin(), collVec->end());
+            for (size_t i = 0; i < entries_.size(); i++) {
+                (*collVec)[i] = objects_[entries_[i].index];
+            }
+        }
+
+        /**
+         * Put an MCParticle collection in depth-first ancestry order, starting from the
+         * particles without parents in their current order.
+         */
+        void sortParticles(IMPL::LCCollectionVec* collVec) {
+            objects_.clear();
+            visited_.clear();
+            for (auto object : *collVec) {
+                auto particle = static_cast<EVENT::MCParticle*>(object);
+                if (particle->getParents().empty()) {
+                    addDepthFirst(particle);
+                }
+            }
+
+            // Particles whose parents are not in the collection are kept at the end.
+            for (auto object : *collVec) {
+                addDepthFirst(static_cast<EVENT::MCParticle*>(object));
+            }
+
+            std::copy(objects_.begin(), objects_.end(), collVec->begin());
+        }
+
+    private:
+
+        struct SortEntry {
+            uint64_t cellID;
+            uint32_t time;
+            uint32_t index;
+        };
+
+        static uint64_t makeCellID(int cellID0, int cellID1) {
+            return ((uint64_t) (uint32_t) cellID1 << 32) | (uint32_t) cellID0;
+        }
+
+        /**
+         * Map a float to an unsigned key with the same order.
+         */
+        static uint32_t makeTimeKey(float time) {
+            uint32_t bits;
+            std::memcpy(&bits, &time, sizeof(bits));
+            return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+        }
+
+        /**
+         * Stable counting sort of the entries by one byte of the cell ID or time key.
+         * Passes where all entries have the same byte are skipped.
+         */
+        void radixPass(int shift, bool cellID) {
+            size_t counts[257] = {0};
+            for (auto& entry : entries_) {
+                ++counts[getByte(entry, shift, cellID) + 1];
+            }
+            for (int i = 0; i < 256; i++) {
+                if (counts[i + 1] == entries_.size()) {
+                    return;
+                }
+            }
+            for (int i = 0; i < 256; i++) {
+                counts[i + 1] += counts[i];
+            }
+            scratch_.resize(entries_.size());
+            for (auto& entry : entries_) {
+                scratch_[counts[getByte(entry, shift, cellID)]++] = entry;
+            }
+            entries_.swap(scratch_);
+        }
+
+        static unsigned getByte(const SortEntry& entry, int shift, bool cellID) {
+            return cellID ? (entry.cellID >> shift) & 0xff : (entry.time >> shift) & 0xff;
+        }
+
+        void addDepthFirst(EVENT::MCParticle* root) {
+            if (visited_.count(root)) {
+                return;
+            }
+            stack_.clear();
+            stack_.push_back(root);
+            while (stack_.size()) {
+                EVENT::MCParticle* particle = stack_.back();
+                stack_.pop_back();
+                if (!visited_.insert(particle).second) {
+                    continue;
+                }
+                objects_.push_back(particle);
+                const auto& daughters = particle->getDaughters();
+                for (auto it = daughters.rbegin(); it != daughters.rend(); ++it) {
+                    if (!visited_.count(*it)) {
+                        stack_.push_back(*it);
+                    }
+                }
+            }
+        }
+
+    private:
+
+        std::vector<SortEntry> entries_;
+        std::vector<SortEntry> scratch_;
+        std::vector<EVENT::LCObject*> objects_;
+        std::vector<EVENT::MCParticle*> stack_;
+        std::unordered_set<EVENT::MCParticle*> visited_;
+};
+
+}
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef HPSSIM_LCIODIGITIZER_H_
+#define HPSSIM_LCIODIGITIZER_H_
+
+/*
+ * Geant4
+ */
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+/*
+ * LCIO
+ */
+#include "EVENT/LCIO.h"
+#include "EVENT/SimCalorimeterHit.h"
+#include "EVENT/SimTrackerHit.h"
+#include "IMPL/CalorimeterHitImpl.h"
+#include "IMPL/LCCollectionVec.h"
+#include "IMPL/LCEventImpl.h"
+#include "IMPL/LCFlagImpl.h"
+#include "IMPL/TrackerDataImpl.h"
+
+/*
+ * C++
+ */
+#include <algorithm>
+#include <cfloat>
+#include <iostream>
+#include <map>
+#include <string>
+
+/*
+ * HPS
+ */
+#include "LcioDigitizerMessenger.h"
+
+namespace hpssim {
+
+/**
+ * @class LcioDigitizer
+ * @brief Digitizes the LCIO sim hit collections of an output event into readout-level collections
+ *
+ * @note
+ * Tracker hits are turned into charge deposits in electrons and calorimeter hits
+ * into energies integrated over the readout window, both with Gaussian noise and
+ * a threshold.  The digitized collections are added to the event and the sim hit
+ * collections can be marked transient so that only the digitized ones are written.
+ * The LCIO units are GeV and ns, while the settings are in Geant4 units.
+ */
+class LcioDigitizer {
+
+    public:
+
+        LcioDigitizer() {
+            messenger_ = new LcioDigitizerMessenger(this);
+        }
+
+        virtual ~LcioDigitizer() {
+            delete messenger_;
+        }
+
+        /**
+         * Return true if any collection should be digitized.
+         */
+        bool isEnabled() {
+            return trackerColls_.size() || ecalColls_.size();
+        }
+
+        /**
+         * Digitize a SimTrackerHit collection into a TrackerData collection.
+         */
+        void addTrackerCollection(std::string simCollName, std::string digiCollName) {
+            trackerColls_[simCollName] = digiCollName;
+        }
+
+        /**
+         * Digitize a SimCalorimeterHit collection into a CalorimeterHit collection.
+         */
+        void addEcalCollection(std::string simCollName, std::string digiCollName) {
+            ecalColls_[simCollName] = digiCollName;
+        }
+
+        /**
+         * Set whether the digitized sim hit collections are left out of the output.
+         */
+        void setDropSimHits(bool dropSimHits) {
+            dropSimHits_ = dropSimHits;
+        }
+
+        void setVerbose(int verbose) {
+            verbose_ = verbose;
+        }
+
+        /**
+         * Set the energy needed to create one electron-hole pair in the tracker sensors.
+         */
+        void setTrackerPairEnergy(double trackerPairEnergy) {
+            trackerPairEnergy_ = trackerPairEnergy;
+        }
+
+        /**
+         * Set the tracker noise in electrons.
+         */
+        void setTrackerNoise(double trackerNoise) {
+            trackerNoise_ = trackerNoise;
+        }
+
+        /**
+         * Set the tracker readout threshold in electrons.
+         */
+        void setTrackerThreshold(double trackerThreshold) {
+            trackerThreshold_ = trackerThreshold;
+        }
+
+        void setEcalNoise(double ecalNoise) {
+            ecalNoise_ = ecalNoise;
+        }
+
+        void setEcalThreshold(double ecalThreshold) {
+            ecalThreshold_ = ecalThreshold;
+        }
+
+        /**
+         * Set the length of the calorimeter integration window starting at the event time,
+         * or zero to integrate all contributions.
+         */
+        void setEcalWindow(double ecalWindow) {
+            ecalWindow_ = ecalWindow;
+        }
+
+        /**
+         * Add the digitized collections to the event.
+         */
+        void digitize(IMPL::LCEventImpl* event) {
+            auto collNames = event->getCollectionNames();
+            for (auto entry : trackerColls_) {
+                if (std::find(collNames->begin(), collNames->end(), entry.first) == collNames->end()) {
+                    continue;
+                }
+                auto simColl = event->getCollection(entry.first);
+                auto digiColl = digitizeTrackerHits(simColl);
+                if (verbose_ > 1) {
+                    std::cout << "LcioDigitizer: Digitized " << simColl->getNumberOfElements() << " hits from '"
+                            << entry.first << "' into " << digiColl->size() << " hits in '"
+                            << entry.second << "'" << std::endl;
+                }
+                event->addCollection(digiColl, entry.second);
+                simColl->setTransient(dropSimHits_);
+            }
+            for (auto entry : ecalColls_) {
+                if (std::find(collNames->begin(), collNames->end(), entry.first) == collNames->end()) {
+                    continue;
+                }
+                auto simColl = event->getCollection(entry.first);
+                auto digiColl = digitizeEcalHits(simColl);
+                if (verbose_ > 1) {
+                    std::cout << "LcioDigitizer: Digitized " << simColl->getNumberOfElements() << " hits from '"
+                            << entry.first << "' into " << digiColl->size() << " hits in '"
+                            << entry.second << "'" << std::endl;
+                }
+                event->addCollection(digiColl, entry.second);
+                simColl->setTransient(dropSimHits_);
+            }
+        }
+
+    private:
+
+        /**
+         * Convert the deposited energy of each tracker hit to a charge with noise
+         * and keep the charges above threshold.
+         */
+        IMPL::LCCollectionVec* digitizeTrackerHits(EVENT::LCCollection* simColl) {
+            auto digiColl = new IMPL::LCCollectionVec(EVENT::LCIO::TRACKERDATA);
+            int nhits = simColl->getNumberOfElements();
+            for (int i = 0; i < nhits; i++) {
+                auto simHit = static_cast<EVENT::SimTrackerHit*>(simColl->getElementAt(i));
+                double charge = simHit->getEDep() * GeV / trackerPairEnergy_;
+                if (trackerNoise_ > 0) {
+                    charge += G4RandGauss::shoot(0, trackerNoise_);
+                }
+                if (charge < trackerThreshold_) {
+                    continue;
+                }
+                auto digiHit = new IMPL::TrackerDataImpl();
+                digiHit->setCellID0(simHit->getCellID0());
+                digiHit->setCellID1(simHit->getCellID1());
+                digiHit->setTime(simHit->getTime());
+                EVENT::FloatVec charges(1, charge);
+                digiHit->setChargeValues(charges);
+                digiColl->push_back(digiHit);
+            }
+            return digiColl;
+        }
+
+        /**
+         * Integrate the energy of each calorimeter hit over the readout window with noise
+         * and keep the energies above threshold.
+         */
+        IMPL::LCCollectionVec* digitizeEcalHits(EVENT::LCCollection* simColl) {
+            auto digiColl = new IMPL::LCCollectionVec(EVENT::LCIO::CALORIMETERHIT);
+            IMPL::LCFlagImpl collFlag;
+            collFlag.setBit(EVENT::LCIO::RCHBIT_LONG);
+            collFlag.setBit(EVENT::LCIO::RCHBIT_TIME);
+            digiColl->setFlag(collFlag.getFlag());
+            int nhits = simColl->getNumberOfElements();
+            for (int i = 0; i < nhits; i++) {
+                auto simHit = static_cast<EVENT::SimCalorimeterHit*>(simColl->getElementAt(i));
+                double energy = 0;
+                double time = DBL_MAX;
+                int ncontribs = simHit->getNMCContributions();
+                if (ncontribs == 0) {
+                    energy = simHit->getEnergy() * GeV;
+                } else {
+                    for (int j = 0; j < ncontribs; j++) {
+                        double contribTime = simHit->getTimeCont(j) * ns;
+                        if (ecalWindow_ > 0 && (contribTime < 0 || contribTime > ecalWindow_)) {
+                            continue;
+                        }
+                        energy += simHit->getEnergyCont(j) * GeV;
+                        time = std::min(time, contribTime);
+                    }
+                }
+                if (time == DBL_MAX) {
+                    time = 0;
+                }
+                if (ecalNoise_ > 0) {
+                    energy += G4RandGauss::shoot(0, ecalNoise_);
+                }
+                if (energy < ecalThreshold_) {
+                    continue;
+                }
+                auto digiHit = new IMPL::CalorimeterHitImpl();
+                digiHit->setCellID0(simHit->getCellID0());
+                digiHit->setCellID1(simHit->getCellID1());
+                digiHit->setEnergy(energy / GeV);
+                digiHit->setTime(time / ns);
+                digiHit->setPosition(simHit->getPosition());
+                digiColl->push_back(digiHit);
+            }
+            return digiColl;
+        }
+
+    private:
+
+        LcioDigitizerMessenger* messenger_;
+
+        /** Map of sim hit collection names to digitized collection names. */
+        std::map<std::string, std::string> trackerColls_;
+        std::map<std::string, std::string> ecalColls_;
+
+        bool dropSimHits_{false};
+        int verbose_{1};
+
+        double trackerPairEnergy_{3.62 * eV};
+        double trackerNoise_{0};
+        double trackerThreshold_{0};
+
+        double ecalNoise_{0};
+        double ecalThreshold_{0};
+        double ecalWindow_{0};
+};
+
+}
+
+#endif
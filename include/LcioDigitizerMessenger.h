@@ -0,0 +1,44 @@
+#ifndef HPSSIM_LCIODIGITIZERMESSENGER_H_
+#define HPSSIM_LCIODIGITIZERMESSENGER_H_
+
+#include "G4UImessenger.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithABool.hh"
+
+namespace hpssim {
+
+class LcioDigitizer;
+
+class LcioDigitizerMessenger : public G4UImessenger {
+
+    public:
+
+        LcioDigitizerMessenger(LcioDigitizer* digitizer);
+
+        void SetNewValue(G4UIcommand* command, G4String newValues);
+
+    private:
+
+        LcioDigitizer* digitizer_;
+
+        G4UIdirectory* digiDir_;
+
+        G4UIcommand* trackerCmd_;
+        G4UIcommand* ecalCmd_;
+        G4UIcmdWithABool* dropSimHitsCmd_;
+        G4UIcmdWithAnInteger* verboseCmd_;
+
+        G4UIcmdWithADoubleAndUnit* trackerPairEnergyCmd_;
+        G4UIcmdWithADouble* trackerNoiseCmd_;
+        G4UIcmdWithADouble* trackerThresholdCmd_;
+
+        G4UIcmdWithADoubleAndUnit* ecalNoiseCmd_;
+        G4UIcmdWithADoubleAndUnit* ecalThresholdCmd_;
+        G4UIcmdWithADoubleAndUnit* ecalWindowCmd_;
+};
+
+}
+
+#endif
@@ -0,0 +1,321 @@
+#ifndef HPSSIM_LCIOEVENTINDEX_H_
+#define HPSSIM_LCIOEVENTINDEX_H_
+
+/*
+ * Geant4
+ */
+#include "globals.hh"
+
+/*
+ * LCIO
+ */
+#include "EVENT/LCCollection.h"
+#include "EVENT/LCEvent.h"
+#include "EVENT/LCIO.h"
+#include "EVENT/SimCalorimeterHit.h"
+#include "IO/LCReader.h"
+#include "IOIMPL/LCFactory.h"
+
+/*
+ * C++
+ */
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @class LcioEventIndex
+ * @brief Per-event summary of LCIO files which is stored in a sidecar file
+ *
+ * @note
+ * For every event, the index stores the run and event numbers, and the number
+ * of elements and the total SimCalorimeterHit energy [GeV] of every collection.
+ * This allows event filters to be evaluated without reading the event itself.
+ * The index of a file is written as text next to it, or into the configured
+ * index directory, with the extension <i>.idx</i> appended.  It is built with
+ * a first pass over the file if that sidecar file does not exist yet, or if the
+ * size and modification time of the LCIO file stored in it do not match.  When
+ * the sidecar file cannot be written the index is only kept in memory.
+ * Energies are written with enough digits to read back the same float values,
+ * so filters give the same result from the index as from the event.
+ */
+class LcioEventIndex {
+
+    public:
+
+        /**
+         * Summary information for one event.
+         * The counts and energies are indexed by the position of the
+         * collection in the list of collection names.
+         */
+        struct Entry {
+            int run{0};
+            int event{0};
+            std::vector<int> counts;
+            std::vector<float> energies;
+        };
+
+        /**
+         * Set the directory where the sidecar index files are written and read,
+         * or an empty string to keep them next to the LCIO files.
+         * The index files in this directory are named after the LCIO file names
+         * without their directories.
+         */
+        void setIndexDirectory(const std::string& indexDir) {
+            indexDir_ = indexDir;
+        }
+
+        /**
+         * Get the name of the sidecar index file for an LCIO file.
+         */
+        std::string getIndexFileName(const std::string& file) const {
+            if (indexDir_.empty()) {
+                return file + ".idx";
+            }
+            size_t slash = file.rfind("/");
+            std::string baseName = slash == std::string::npos ? file : file.substr(slash + 1);
+            return indexDir_ + "/" + baseName + ".idx";
+        }
+
+        /**
+         * Load the index of an LCIO file and append its entries, building and
+         * writing the sidecar file first if it does not exist or is out of date.
+         */
+        void load(const std::string& file) {
+            std::string indexFile = getIndexFileName(file);
+            std::string stamp = getFileStamp(file);
+            if (!read(indexFile, stamp)) {
+                std::cout << "LcioEventIndex: Building index of '" << file << "'" << std::endl;
+                LcioEventIndex fileIndex;
+                fileIndex.build(file);
+                if (!fileIndex.write(indexFile, stamp) || !read(indexFile, stamp)) {
+                    std::cerr << "LcioEventIndex: Failed to write index file '" << indexFile
+                            << "'; keeping the index in memory" << std::endl;
+                    append(fileIndex);
+                }
+            }
+        }
+
+        /**
+         * Build the index by reading every event in an LCIO file.
+         */
+        void build(const std::string& file) {
+            auto reader = IOIMPL::LCFactory::getInstance()->createLCReader();
+            reader->open(file);
+            EVENT::LCEvent* event = reader->readNextEvent();
+            while (event) {
+                add(event);
+                event = reader->readNextEvent();
+            }
+            try {
+                reader->close();
+            } catch (std::exception& e) {
+                std::cerr << e.what() << std::endl;
+            }
+            delete reader;
+        }
+
+        /**
+         * Add the summary of an event to the index.
+         */
+        void add(EVENT::LCEvent* event) {
+            Entry entry;
+            entry.run = event->getRunNumber();
+            entry.event = event->getEventNumber();
+            for (auto collName : *event->getCollectionNames()) {
+                auto coll = event->getCollection(collName);
+                float energy = 0;
+                if (coll->getTypeName() == EVENT::LCIO::SIMCALORIMETERHIT) {
+                    for (int iElem = 0; iElem < coll->getNumberOfElements(); iElem++) {
+                        energy += static_cast<EVENT::SimCalorimeterHit*>(coll->getElementAt(iElem))->getEnergy();
+                    }
+                }
+                set(entry, addCollection(collName), coll->getNumberOfElements(), energy);
+            }
+            entries_.push_back(entry);
+        }
+
+        /**
+         * Write the index to a text file, starting with the stamp of the indexed LCIO file.
+         * @return False if the file could not be written.
+         */
+        bool write(const std::string& indexFile, const std::string& stamp) {
+            std::ofstream out(indexFile.c_str());
+            if (!out.is_open()) {
+                return false;
+            }
+            out << std::setprecision(std::numeric_limits<float>::max_digits10);
+            out << "file " << stamp << std::endl;
+            out << "collections";
+            for (auto& collName : collNames_) {
+                out << " " << collName;
+            }
+            out << std::endl;
+            for (auto& entry : entries_) {
+                out << entry.run << " " << entry.event;
+                for (unsigned iColl = 0; iColl < collNames_.size(); iColl++) {
+                    out << " " << getCount(entry, iColl) << " " << getEnergy(entry, iColl);
+                }
+                out << std::endl;
+            }
+            out.close();
+            if (out.fail()) {
+                std::remove(indexFile.c_str());
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * Read an index text file and append its entries.
+         * @return False if the file could not be opened or was written for a
+         * different version of the LCIO file.
+         */
+        bool read(const std::string& indexFile, const std::string& stamp) {
+            std::ifstream in(indexFile.c_str());
+            if (!in.is_open()) {
+                return false;
+            }
+            std::string line, word;
+            std::vector<int> collIndices;
+            std::getline(in, line);
+            if (line != "file " + stamp) {
+                std::cout << "LcioEventIndex: Index file '" << indexFile << "' is out of date" << std::endl;
+                return false;
+            }
+            std::getline(in, line);
+            std::stringstream header(line);
+            header >> word;
+            while (header >> word) {
+                collIndices.push_back(addCollection(word));
+            }
+            while (std::getline(in, line)) {
+                if (line.empty()) {
+                    continue;
+                }
+                std::stringstream ss(line);
+                Entry entry;
+                ss >> entry.run >> entry.event;
+                for (auto collIndex : collIndices) {
+                    int count = 0;
+                    float energy = 0;
+                    ss >> count >> energy;
+                    set(entry, collIndex, count, energy);
+                }
+                entries_.push_back(entry);
+            }
+            return true;
+        }
+
+        /**
+         * Get the position of a collection in the index or -1 if it is not indexed.
+         */
+        int getCollectionIndex(const std::string& collName) const {
+            for (unsigned iColl = 0; iColl < collNames_.size(); iColl++) {
+                if (collNames_[iColl] == collName) {
+                    return iColl;
+                }
+            }
+            return -1;
+        }
+
+        /**
+         * Get the number of elements in a collection for an entry.
+         */
+        static int getCount(const Entry& entry, int collIndex) {
+            return collIndex >= 0 && collIndex < (int) entry.counts.size() ? entry.counts[collIndex] : 0;
+        }
+
+        /**
+         * Get the total SimCalorimeterHit energy [GeV] in a collection for an entry.
+         */
+        static float getEnergy(const Entry& entry, int collIndex) {
+            return collIndex >= 0 && collIndex < (int) entry.energies.size() ? entry.energies[collIndex] : 0;
+        }
+
+        const std::vector<Entry>& getEntries() const {
+            return entries_;
+        }
+
+        const std::vector<std::string>& getCollectionNames() const {
+            return collNames_;
+        }
+
+    private:
+
+        /**
+         * Get the size and modification time of a file, which identify the version
+         * of the file that was indexed.
+         */
+        static std::string getFileStamp(const std::string& file) {
+            struct stat fileStat;
+            if (stat(file.c_str(), &fileStat) != 0) {
+                return "0 0";
+            }
+            return std::to_string((long long) fileStat.st_size) + " " + std::to_string((long long) fileStat.st_mtime);
+        }
+
+        /**
+         * Append the entries of another index.
+         */
+        void append(const LcioEventIndex& index) {
+            std::vector<int> collIndices;
+            for (auto& collName : index.collNames_) {
+                collIndices.push_back(addCollection(collName));
+            }
+            for (auto& fileEntry : index.entries_) {
+                Entry entry;
+                entry.run = fileEntry.run;
+                entry.event = fileEntry.event;
+                for (unsigned iColl = 0; iColl < collIndices.size(); iColl++) {
+                    set(entry, collIndices[iColl], getCount(fileEntry, iColl), getEnergy(fileEntry, iColl));
+                }
+                entries_.push_back(entry);
+            }
+        }
+
+        /**
+         * Get the position of a collection, adding it to the index if necessary.
+         */
+        int addCollection(const std::string& collName) {
+            int collIndex = getCollectionIndex(collName);
+            if (collIndex == -1) {
+                collIndex = collNames_.size();
+                collNames_.push_back(collName);
+            }
+            return collIndex;
+        }
+
+        static void set(Entry& entry, int collIndex, int count, float energy) {
+            if (collIndex >= (int) entry.counts.size()) {
+                entry.counts.resize(collIndex + 1, 0);
+                entry.energies.resize(collIndex + 1, 0);
+            }
+            entry.counts[collIndex] = count;
+            entry.energies[collIndex] = energy;
+        }
+
+    private:
+
+        /** Names of the indexed collections. */
+        std::vector<std::string> collNames_;
+
+        /** Event summaries in file order. */
+        std::vector<Entry> entries_;
+
+        /** Directory of the sidecar index files, or empty to write them next to the LCIO files. */
+        std::string indexDir_;
+};
+
+}
+
+#endif
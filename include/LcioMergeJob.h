@@ -0,0 +1,244 @@
+#ifndef HPSSIM_LCIOMERGEJOB_H_
+#define HPSSIM_LCIOMERGEJOB_H_
+
+/*
+ * Geant4
+ */
+#include "G4StateManager.hh"
+#include "G4VExceptionHandler.hh"
+
+/*
+ * LCIO
+ */
+#include "EVENT/LCIO.h"
+#include "IMPL/LCEventImpl.h"
+#include "IMPL/LCRunHeaderImpl.h"
+#include "IO/LCReader.h"
+#include "IO/LCWriter.h"
+#include "IOIMPL/LCFactory.h"
+
+/*
+ * C++
+ */
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * HPS
+ */
+#include "LcioMergeJobMessenger.h"
+#include "LcioMergeTool.h"
+
+namespace hpssim {
+
+/**
+ * @class LcioMergeJob
+ * @brief Merges LCIO event streams into a base stream without running a simulation
+ *
+ * @note
+ * Each base event is read from the input files, the configured merge tools
+ * are applied to it in the same way as in hps-sim, and it is written to the
+ * output file.  If there are no input files then empty events are generated
+ * as targets instead.  This is used by the hps-merge application, which does
+ * not need any Geant4 geometry or physics initialization.
+ */
+class LcioMergeJob {
+
+    public:
+
+        /**
+         * @class ExceptionHandler
+         * @brief Stops the merge loop when a merge tool requests to abort the run
+         *
+         * @note This replaces the handler which is normally created by the Geant4 run manager.
+         */
+        class ExceptionHandler : public G4VExceptionHandler {
+
+            public:
+
+                ExceptionHandler(LcioMergeJob* job) : job_(job) {
+                }
+
+                G4bool Notify(const char* originOfException,
+                        const char* exceptionCode,
+                        G4ExceptionSeverity severity,
+                        const char* description) {
+                    std::cerr << "LcioMergeJob: Exception in " << originOfException
+                            << " " << exceptionCode << ": " << description << std::endl;
+                    if (severity == RunMustBeAborted || severity == EventMustBeAborted) {
+                        job_->abort();
+                        return false;
+                    }
+                    return severity != JustWarning;
+                }
+
+            private:
+
+                LcioMergeJob* job_;
+        };
+
+        LcioMergeJob() {
+            handler_ = new ExceptionHandler(this);
+            messenger_ = new LcioMergeJobMessenger(this);
+        }
+
+        virtual ~LcioMergeJob() {
+            for (auto entry : merge_) {
+                delete entry.second;
+            }
+            merge_.clear();
+            delete messenger_;
+            G4StateManager::GetStateManager()->SetExceptionHandler(nullptr);
+            delete handler_;
+        }
+
+        /**
+         * Add an LCIO file from which base events are read.
+         */
+        void addInputFile(std::string file) {
+            inputFiles_.push_back(file);
+        }
+
+        /**
+         * Set the name of the output file.
+         */
+        void setOutputFile(std::string outputFile) {
+            outputFile_ = outputFile;
+        }
+
+        /**
+         * Set the maximum number of events to write, or -1 for all base events.
+         */
+        void setMaxEvents(int maxEvents) {
+            maxEvents_ = maxEvents;
+        }
+
+        void setVerbose(int verbose) {
+            verbose_ = verbose;
+        }
+
+        /**
+         * Add a merge tool which is applied to every base event.
+         */
+        void addMerge(LcioMergeTool* merge) {
+            merge_[merge->getName()] = merge;
+        }
+
+        /**
+         * Stop the merge loop after the current event.
+         */
+        void abort() {
+            aborted_ = true;
+        }
+
+        /**
+         * Merge the configured streams into the base events and write them out.
+         * @return The number of events which were written.
+         */
+        int run() {
+
+            if (outputFile_.empty()) {
+                G4Exception("LcioMergeJob::run", "", FatalException, "No output file was set.");
+            }
+            if (inputFiles_.empty() && maxEvents_ < 0) {
+                G4Exception("LcioMergeJob::run", "", FatalException,
+                        "The number of events must be set when there are no input files.");
+            }
+
+            for (auto entry : merge_) {
+                if (verbose_ > 1) {
+                    std::cout << "LcioMergeJob: Initializing merge tool '" << entry.first << "'" << std::endl;
+                }
+                entry.second->setVerbose(verbose_);
+                entry.second->initialize();
+            }
+
+            IO::LCReader* reader = nullptr;
+            if (inputFiles_.size()) {
+                reader = IOIMPL::LCFactory::getInstance()->createLCReader();
+                reader->open(inputFiles_);
+            }
+
+            if (verbose_ > 0) {
+                std::cout << "LcioMergeJob: Writing merged events to '" << outputFile_ << "'" << std::endl;
+            }
+            auto writer = IOIMPL::LCFactory::getInstance()->createLCWriter();
+            writer->open(outputFile_, EVENT::LCIO::WRITE_NEW);
+
+            auto runHeader = new IMPL::LCRunHeaderImpl();
+            runHeader->setDescription("HPS merged events");
+            writer->writeRunHeader(static_cast<EVENT::LCRunHeader*>(runHeader));
+            delete runHeader;
+
+            int nEvents = 0;
+            aborted_ = false;
+            while (!aborted_ && (maxEvents_ < 0 || nEvents < maxEvents_)) {
+
+                // get the next base event, which is owned by the reader
+                IMPL::LCEventImpl* event = nullptr;
+                IMPL::LCEventImpl* emptyEvent = nullptr;
+                if (reader) {
+                    event = dynamic_cast<IMPL::LCEventImpl*>(reader->readNextEvent(EVENT::LCIO::UPDATE));
+                    if (!event) {
+                        break;
+                    }
+                } else {
+                    emptyEvent = new IMPL::LCEventImpl();
+                    emptyEvent->setEventNumber(nEvents);
+                    event = emptyEvent;
+                }
+
+                for (auto entry : merge_) {
+                    if (verbose_ > 2) {
+                        std::cout << "LcioMergeJob: Merging from '" << entry.first << "' into event "
+                                << event->getEventNumber() << std::endl;
+                    }
+                    entry.second->mergeEvents(event);
+                }
+
+                if (!aborted_) {
+                    writer->writeEvent(static_cast<EVENT::LCEvent*>(event));
+                    ++nEvents;
+                    if (verbose_ > 1 && nEvents % 1000 == 0) {
+                        std::cout << "LcioMergeJob: Wrote " << nEvents << " events" << std::endl;
+                    }
+                }
+
+                if (emptyEvent) {
+                    delete emptyEvent;
+                }
+            }
+
+            writer->close();
+            delete writer;
+
+            if (reader) {
+                reader->close();
+                delete reader;
+            }
+
+            if (verbose_ > 0) {
+                std::cout << "LcioMergeJob: Wrote " << nEvents << " merged events" << std::endl;
+            }
+
+            return nEvents;
+        }
+
+    private:
+
+        LcioMergeJobMessenger* messenger_;
+        ExceptionHandler* handler_;
+
+        std::vector<std::string> inputFiles_;
+        std::string outputFile_;
+        int maxEvents_{-1};
+        int verbose_{1};
+        bool aborted_{false};
+
+        std::map<std::string, LcioMergeTool*> merge_;
+};
+
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef HPSSIM_LCIOMERGEJOBMESSENGER_H_
+#define HPSSIM_LCIOMERGEJOBMESSENGER_H_
+
+#include "G4UImessenger.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+namespace hpssim {
+
+class LcioMergeJob;
+
+/**
+ * @class LcioMergeJobMessenger
+ * @brief Macro commands for the standalone merge application
+ *
+ * @note The command for adding merge tools has the same name as in hps-sim
+ * so that merge macros can be shared between the two applications.
+ */
+class LcioMergeJobMessenger : public G4UImessenger {
+
+    public:
+
+        LcioMergeJobMessenger(LcioMergeJob* job);
+
+        void SetNewValue(G4UIcommand* command, G4String newValues);
+
+    private:
+
+        LcioMergeJob* job_;
+
+        G4UIdirectory* dir_;
+        G4UIcmdWithAString* inputCmd_;
+        G4UIcmdWithAString* fileCmd_;
+        G4UIcmdWithAnInteger* neventsCmd_;
+        G4UIcmdWithAnInteger* verboseCmd_;
+
+        G4UIdirectory* lcioDir_;
+        G4UIdirectory* mergeDir_;
+        G4UIcmdWithAString* mergeAddCmd_;
+};
+
+}
+
+#endif
@@ -27,7 +27,14 @@ class LcioMergeMessenger : public G4UImessenger {
         G4UIdirectory* filterDir_;
 
         G4UIcmdWithAString* fileCmd_;
+        G4UIcmdWithAString* collectionCmd_;
+        G4UIcmdWithAString* readCollectionCmd_;
         G4UIcmdWithABool* combineCalHitsCmd_;
+        G4UIcmdWithABool* indexCmd_;
+        G4UIcmdWithAString* indexDirCmd_;
+        G4UIcmdWithAnInteger* poolCmd_;
+        G4UIcmdWithAString* poolSamplingCmd_;
+        G4UIcmdWithABool* poolReservoirCmd_;
 
         G4UIcmdWithADoubleAndUnit* ecalEnergyFilterCmd_;
         G4UIcmdWithAnInteger* eventModulusFilterCmd_;
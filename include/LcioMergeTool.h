@@ -5,20 +5,33 @@
  * Geant4
  */
 #include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
 
 /*
  * LCIO
  */
 #include "EVENT/LCCollection.h"
+#include "Exceptions.h"
 #include "IMPL/LCEventImpl.h"
 #include "IMPL/LCCollectionVec.h"
+#include "IMPL/MCParticleImpl.h"
 #include "IMPL/SimCalorimeterHitImpl.h"
+#include "IMPL/SimTrackerHitImpl.h"
 #include "IO/LCReader.h"
 #include "IOIMPL/LCFactory.h"
 
+/*
+ * C++
+ */
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
 /*
  * HPS
  */
+#include "LcioEventIndex.h"
 #include "LcioMergeMessenger.h"
 
 namespace hpssim {
@@ -35,9 +48,17 @@ class LcioMergeTool {
     public:
 
         /**
-         * Pair of 32-bit IDs used to uniquely identify hits.
+         * Pair of 32-bit IDs packed into a 64-bit ID used to uniquely identify hits.
          */
-        typedef std::pair<int, int> CellID;
+        typedef uint64_t CellID;
+
+        /**
+         * How events are drawn from the in-memory event pool.
+         */
+        enum PoolSampling {
+            Cyclic,
+            Random
+        };
 
         /**
          * @class MergeFilter
@@ -54,6 +75,15 @@ class LcioMergeTool {
                     return true;
                 }
 
+                /**
+                 * Return true if the filter should accept the source event
+                 * described by an index entry.  Filters that cannot be
+                 * evaluated from the index should accept every entry.
+                 */
+                virtual bool accept(const LcioEventIndex&, const LcioEventIndex::Entry&) {
+                    return true;
+                }
+
                 /**
                  * Return true if the filter should skip this target event,
                  * which means that no events will be merged into it from this
@@ -62,6 +92,14 @@ class LcioMergeTool {
                 virtual bool skip(EVENT::LCEvent*) {
                     return false;
                 }
+
+                /**
+                 * Get the collections of the source events which this filter reads,
+                 * which are read even if only some collections are merged.
+                 */
+                virtual std::vector<std::string> getRequiredCollections() {
+                    return {};
+                }
         };
 
         /**
@@ -74,7 +112,7 @@ class LcioMergeTool {
 
                 bool accept(EVENT::LCEvent* event) {
                     auto hits = event->getCollection(collName_);
-                    float e;
+                    float e = 0;
                     for (int iElem = 0; iElem < hits->getNumberOfElements(); iElem++) {
                         EVENT::SimCalorimeterHit* hit =
                                 static_cast<EVENT::SimCalorimeterHit*>(hits->getElementAt(iElem));
@@ -83,10 +121,19 @@ class LcioMergeTool {
                     return e >= energyCut_;
                 }
 
+                bool accept(const LcioEventIndex& index, const LcioEventIndex::Entry& entry) {
+                    float e = LcioEventIndex::getEnergy(entry, index.getCollectionIndex(collName_)) * GeV;
+                    return e >= energyCut_;
+                }
+
                 void setEnergyCut(float energyCut) {
                     energyCut_ = energyCut;
                 }
 
+                std::vector<std::string> getRequiredCollections() {
+                    return {collName_};
+                }
+
             private:
 
                 float energyCut_{50 * MeV};
@@ -130,6 +177,12 @@ class LcioMergeTool {
                 delete reader_;
             }
 
+            if (index_) {
+                delete index_;
+            }
+
+            clearPool();
+
             delete messenger_;
         }
 
@@ -150,6 +203,9 @@ class LcioMergeTool {
         /**
          * Set whether SimCalorimeterHit objects with the same cell IDs should be combined
          * into a single output hit.
+         *
+         * @note LCRelation collections from or to SimCalorimeterHits are not merged when
+         * this is enabled, because the hits they point to are replaced.
          */
         void setCombineCalHits(bool combineCalHits) {
             combineCalHits_ = combineCalHits;
@@ -160,67 +216,110 @@ class LcioMergeTool {
          *
          * If writeColls is not empty then only collection names that it
          * contains will be written out to the target event.
+         *
+         * @note The list of source collections to merge is computed from the
+         * first event and cached for the stream, so all events in the stream
+         * are expected to contain the same collections.
          */
         void mergeEvent(EVENT::LCEvent* src, IMPL::LCEventImpl* target, const std::vector<std::string>& writeColls) {
 
-            // Names of collections in source event.
-            const std::vector<std::string>* srcCollNames = src->getCollectionNames();
+            // Cache names of source collections to be merged for this stream.
+            if (!mergeCollsCached_ || writeColls != cachedWriteColls_) {
+                mergeCollNames_.clear();
+                for (auto collName : *src->getCollectionNames()) {
+                    if (writeColls.size() == 0 ||
+                            std::find(writeColls.begin(), writeColls.end(), collName) != writeColls.end()) {
+                        mergeCollNames_.push_back(collName);
+                    }
+                }
+                cachedWriteColls_ = writeColls;
+                mergeCollsCached_ = true;
+            }
 
             // Names of collections in target event.
-            const std::vector<std::string>* targetCollNames = src->getCollectionNames();
+            const std::vector<std::string>* targetCollNames = target->getCollectionNames();
 
             // Process source collection names.
-            for (auto collName : *srcCollNames) {
-
-                // Check if this collection should be written.
-                if (writeColls.size() == 0 || 
-                        std::find(writeColls.begin(), writeColls.end(), collName) != writeColls.end()) {
+            for (auto& collName : mergeCollNames_) {
 
-                    // Get source collection and take ownership so it is not automatically deleted by the reader.
-                    auto srcColl = src->getCollection(collName);
-                    src->takeCollection(collName);
+                // Get source collection and take ownership so it is not automatically deleted by the reader.
+                EVENT::LCCollection* srcColl = nullptr;
+                try {
+                    srcColl = src->takeCollection(collName);
+                } catch (EVENT::DataNotAvailableException& e) {
+                    if (verbose_ > 1) {
+                        std::cout << "LcioMergeTool: Collection '" << collName << "' missing from source event "
+                                << src->getEventNumber() << std::endl;
+                    }
+                    continue;
+                }
 
-                    // Get target collection from output event if it exists, or create new one if not.
-                    IMPL::LCCollectionVec* targetColl = nullptr;
-                    bool createdNewCollection = false;
-                    if (std::find(targetCollNames->begin(), targetCollNames->end(), collName) != targetCollNames->end()) {
-                        targetColl = (IMPL::LCCollectionVec*) target->getCollection(collName);
-                    } else {
-                        targetColl = new IMPL::LCCollectionVec(srcColl->getTypeName());
-                        target->addCollection(targetColl, collName);
-                        createdNewCollection = true;
+                // Relations to SimCalorimeterHits would point to deleted hits after combining.
+                if (combineCalHits_ && isCalHitRelation(srcColl)) {
+                    if (verbose_ > 1) {
+                        std::cout << "LcioMergeTool: Skipping relation collection '" << collName
+                                << "' because cal hits are combined" << std::endl;
                     }
+                    delete srcColl;
+                    continue;
+                }
 
-                    // Add all elements from source to target collection.
-                    addElements(srcColl, targetColl);
+                // Get target collection from output event if it exists, or create new one if not.
+                IMPL::LCCollectionVec* targetColl = nullptr;
+                bool createdNewCollection = false;
+                if (std::find(targetCollNames->begin(), targetCollNames->end(), collName) != targetCollNames->end()) {
+                    targetColl = (IMPL::LCCollectionVec*) target->getCollection(collName);
+                } else {
+                    targetColl = new IMPL::LCCollectionVec(srcColl->getTypeName());
+                    target->addCollection(targetColl, collName);
+                    createdNewCollection = true;
+                }
+                bool targetHasElements = targetColl->size() > 0;
 
-                    // Combine SimCalorimeterHit objects in place.
-                    if (srcColl->getTypeName() == EVENT::LCIO::SIMCALORIMETERHIT
-                            && combineCalHits_ && !createdNewCollection
-                            && srcColl->getNumberOfElements() != targetColl->getNumberOfElements()) {
-                        if (verbose_ > 1) {
-                            std::cout << "LcioMergeTool: Combining " << targetColl->getNumberOfElements() << " hits in '"
-                                    << collName << "'" << std::endl;
-                        }
-                        combine(targetColl);
-                        if (verbose_ > 1) {
-                            std::cout << "LcioMergeTool: Created " << targetColl->getNumberOfElements() << " combined cal hits" << std::endl;
-                        }
-                    }
+                // Move all elements from source to target collection.
+                addElements(srcColl, targetColl);
 
-                    // Clear and delete the source collection which we took from the event.
-                    clear(srcColl);
-                    delete srcColl;
+                // Combine SimCalorimeterHit objects in place.
+                if (srcColl->getTypeName() == EVENT::LCIO::SIMCALORIMETERHIT
+                        && combineCalHits_ && !createdNewCollection && targetHasElements) {
+                    if (verbose_ > 1) {
+                        std::cout << "LcioMergeTool: Combining " << targetColl->getNumberOfElements() << " hits in '"
+                                << collName << "'" << std::endl;
+                    }
+                    combine(targetColl);
+                    if (verbose_ > 1) {
+                        std::cout << "LcioMergeTool: Created " << targetColl->getNumberOfElements() << " combined cal hits" << std::endl;
+                    }
                 }
+
+                // Delete the now empty source collection which we took from the event.
+                delete srcColl;
+            }
+        }
+
+        /**
+         * Return true if a collection holds LCRelation objects from or to SimCalorimeterHits.
+         */
+        static bool isCalHitRelation(EVENT::LCCollection* coll) {
+            if (coll->getTypeName() != EVENT::LCIO::LCRELATION) {
+                return false;
             }
+            const EVENT::LCParameters& params = coll->getParameters();
+            return params.getStringVal("FromType") == EVENT::LCIO::SIMCALORIMETERHIT
+                    || params.getStringVal("ToType") == EVENT::LCIO::SIMCALORIMETERHIT;
         }
 
         /**
-         * Clear all data members of an LCCollection.
+         * Clear all data members of an LCCollection without deleting them.
          */
         static void clear(EVENT::LCCollection* coll) {
-            for (int iElem = coll->getNumberOfElements() - 1; iElem >= 0; iElem--) {
-                coll->removeElementAt(iElem);
+            auto collVec = dynamic_cast<IMPL::LCCollectionVec*>(coll);
+            if (collVec) {
+                collVec->clear();
+            } else {
+                for (int iElem = coll->getNumberOfElements() - 1; iElem >= 0; iElem--) {
+                    coll->removeElementAt(iElem);
+                }
             }
         }
 
@@ -236,8 +335,9 @@ class LcioMergeTool {
          * Merge one event from the reader into the target output event,
          * applying any event filters to read events until one is found
          * that passes.
+         *
+         * If the event pool is enabled then a copy of a pooled event is merged instead.
          */
-        // FIXME: Check for event underflow when reading events!
         void mergeEvents(IMPL::LCEventImpl* target) {
 
             // check if merge filter wants to skip this output event
@@ -247,8 +347,28 @@ class LcioMergeTool {
                 }
             }
 
+            // merge a copy of the next event from the pool
+            if (poolSize_ > 0) {
+                auto event = copyEvent(nextPoolEvent());
+                mergeEvent(event, target, collections_);
+                delete event;
+                return;
+            }
+
+            // read next src event which passes the filters using the index
+            if (index_) {
+                auto event = readNextIndexedEvent();
+                if (event) {
+                    mergeEvent(event, target, collections_);
+                }
+                return;
+            }
+
             // read next src event
-            auto event = reader_->readNextEvent(EVENT::LCIO::UPDATE);
+            auto event = readNextEvent();
+            if (!event) {
+                return;
+            }
 
             // if necessary read events until one passes the filters
             if (filters_.size()) {
@@ -258,7 +378,10 @@ class LcioMergeTool {
                         std::cout << "LcioMergeTool: Event " << event->getEventNumber()
                                 << " rejected by filters of '" << getName() << "'" << std::endl;
                     }
-                    event = reader_->readNextEvent(EVENT::LCIO::UPDATE);
+                    event = readNextEvent();
+                    if (!event) {
+                        return;
+                    }
                     acceptEvent = accept(event, filters_);
                 }
                 if (verbose_ > 2) {
@@ -268,7 +391,7 @@ class LcioMergeTool {
             }
 
             // finally merge source event after filtering to target
-            mergeEvent(event, target);
+            mergeEvent(event, target, collections_);
         }
 
         /**
@@ -278,6 +401,63 @@ class LcioMergeTool {
             files_.push_back(file);
         }
 
+        /**
+         * Add the name of a collection to merge into the target event.
+         * If no collections are added then all collections are merged.
+         * Only the collections to merge and any extra read collections
+         * are read from the source events.
+         */
+        void addCollection(std::string collName) {
+            collections_.push_back(collName);
+        }
+
+        /**
+         * Add the name of a collection to read from the source events without
+         * merging it, e.g. for use by a filter.
+         */
+        void addReadCollection(std::string collName) {
+            readCollections_.push_back(collName);
+        }
+
+        /**
+         * Set whether a sidecar event index should be used to apply the filters
+         * before source events are read.
+         */
+        void setUseIndex(bool useIndex) {
+            useIndex_ = useIndex;
+        }
+
+        /**
+         * Set the directory of the sidecar index files, e.g. if the input files
+         * are in a read only directory.
+         */
+        void setIndexDirectory(std::string indexDir) {
+            indexDir_ = indexDir;
+        }
+
+        /**
+         * Set the number of source events to keep in memory and reuse.
+         * Zero disables the pool, so events are read sequentially instead.
+         */
+        void setPoolSize(int poolSize) {
+            poolSize_ = poolSize > 0 ? poolSize : 0;
+        }
+
+        /**
+         * Set how events are drawn from the pool.
+         */
+        void setPoolSampling(PoolSampling poolSampling) {
+            poolSampling_ = poolSampling;
+        }
+
+        /**
+         * Set whether the pool is filled by reservoir sampling over the whole stream
+         * instead of from the first accepted events.
+         */
+        void setPoolReservoir(bool poolReservoir) {
+            poolReservoir_ = poolReservoir;
+        }
+
         /**
          * Add an event filter.
          */
@@ -294,11 +474,284 @@ class LcioMergeTool {
                 delete reader_;
             }
             reader_ = IOIMPL::LCFactory::getInstance()->createLCReader();
+
+            // only read the collections that are needed from the source events
+            if (collections_.size()) {
+                std::vector<std::string> readColls(collections_);
+                readColls.insert(readColls.end(), readCollections_.begin(), readCollections_.end());
+                for (auto filter : filters_) {
+                    for (auto& collName : filter->getRequiredCollections()) {
+                        if (std::find(readColls.begin(), readColls.end(), collName) == readColls.end()) {
+                            readColls.push_back(collName);
+                        }
+                    }
+                }
+                if (verbose_ > 1) {
+                    std::cout << "LcioMergeTool: Reading " << readColls.size() << " collections for '"
+                            << getName() << "'" << std::endl;
+                }
+                reader_->setReadCollectionNames(readColls);
+            }
+
             reader_->open(files_);
+
+            // fill the event pool, which replaces reading events during the run
+            if (poolSize_ > 0) {
+                loadPool();
+                return;
+            }
+
+            // load the event index of every file
+            if (index_) {
+                delete index_;
+                index_ = nullptr;
+            }
+            if (useIndex_) {
+                index_ = new LcioEventIndex;
+                index_->setIndexDirectory(indexDir_);
+                for (auto& file : files_) {
+                    index_->load(file);
+                }
+                position_ = 0;
+                if (verbose_ > 1) {
+                    std::cout << "LcioMergeTool: Loaded index with " << index_->getEntries().size()
+                            << " events for '" << getName() << "'" << std::endl;
+                }
+            }
         }
 
     private:
 
+        /**
+         * Read the next source event, aborting the run and returning null if there
+         * are no more events.
+         */
+        EVENT::LCEvent* readNextEvent() {
+            auto event = reader_->readNextEvent(EVENT::LCIO::UPDATE);
+            if (!event) {
+                std::cerr << "LcioMergeTool: No more events to merge from '" << getName() << "'" << std::endl;
+                G4Exception("LcioMergeTool::readNextEvent", "", RunMustBeAborted, "No more events to merge.");
+            }
+            return event;
+        }
+
+        /**
+         * Fill the event pool with source events that pass the filters.
+         *
+         * @note With reservoir sampling every accepted event in the stream is read, and
+         * each of them ends up in the pool with equal probability.  Otherwise reading
+         * stops once the pool is full.  The sidecar index is not used here.
+         */
+        void loadPool() {
+            clearPool();
+            pool_.reserve(poolSize_);
+            long nAccepted = 0;
+            auto event = reader_->readNextEvent(EVENT::LCIO::UPDATE);
+            while (event) {
+                if (accept(event, filters_)) {
+                    if (pool_.size() < poolSize_) {
+                        pool_.push_back(takeEvent(event));
+                    } else if (poolReservoir_) {
+                        long slot = (long) (G4UniformRand() * (nAccepted + 1));
+                        if (slot < (long) poolSize_) {
+                            delete pool_[slot];
+                            pool_[slot] = takeEvent(event);
+                        }
+                    } else {
+                        break;
+                    }
+                    ++nAccepted;
+                }
+                event = reader_->readNextEvent(EVENT::LCIO::UPDATE);
+            }
+            if (pool_.empty()) {
+                std::cerr << "LcioMergeTool: No events were accepted into the pool of '" << getName() << "'" << std::endl;
+                G4Exception("LcioMergeTool::loadPool", "", FatalException, "Event pool is empty.");
+            }
+            if (verbose_ > 1) {
+                std::cout << "LcioMergeTool: Loaded " << pool_.size() << " of " << nAccepted
+                        << " accepted events into the pool of '" << getName() << "'" << std::endl;
+            }
+        }
+
+        /**
+         * Delete all events in the pool.
+         */
+        void clearPool() {
+            for (auto event : pool_) {
+                delete event;
+            }
+            pool_.clear();
+            poolNext_ = 0;
+        }
+
+        /**
+         * Get the next pooled event according to the sampling mode.
+         */
+        IMPL::LCEventImpl* nextPoolEvent() {
+            if (poolSampling_ == Random) {
+                size_t iEvent = (size_t) (G4UniformRand() * pool_.size());
+                return pool_[std::min(iEvent, pool_.size() - 1)];
+            }
+            auto event = pool_[poolNext_];
+            poolNext_ = (poolNext_ + 1) % pool_.size();
+            return event;
+        }
+
+        /**
+         * Returns true if collections of this type can be copied from the pool.
+         */
+        static bool isPoolable(const std::string& typeName) {
+            return typeName == EVENT::LCIO::MCPARTICLE
+                    || typeName == EVENT::LCIO::SIMTRACKERHIT
+                    || typeName == EVENT::LCIO::SIMCALORIMETERHIT;
+        }
+
+        /**
+         * Take the collections to merge from an event read by the reader into a new
+         * event which is owned by the pool.
+         */
+        IMPL::LCEventImpl* takeEvent(EVENT::LCEvent* src) {
+            auto event = new IMPL::LCEventImpl;
+            event->setRunNumber(src->getRunNumber());
+            event->setEventNumber(src->getEventNumber());
+            std::vector<std::string> collNames(*src->getCollectionNames());
+            for (auto& collName : collNames) {
+                if (collections_.size()
+                        && std::find(collections_.begin(), collections_.end(), collName) == collections_.end()) {
+                    continue;
+                }
+                auto coll = src->getCollection(collName);
+                if (!isPoolable(coll->getTypeName())) {
+                    if (verbose_ > 0 && pool_.empty()) {
+                        std::cerr << "LcioMergeTool: Collection '" << collName << "' of type " << coll->getTypeName()
+                                << " cannot be pooled and will not be merged from '" << getName() << "'" << std::endl;
+                    }
+                    continue;
+                }
+                event->addCollection(src->takeCollection(collName), collName);
+            }
+            return event;
+        }
+
+        /**
+         * Make a deep copy of a pooled event which can be merged into the target event.
+         *
+         * @note MCParticle collections are copied first so that the parents of the particles
+         * and the hit contributions can be pointed at the copies.
+         */
+        IMPL::LCEventImpl* copyEvent(IMPL::LCEventImpl* src) {
+            auto copy = new IMPL::LCEventImpl;
+            copy->setRunNumber(src->getRunNumber());
+            copy->setEventNumber(src->getEventNumber());
+            particleCopies_.clear();
+            auto collNames = src->getCollectionNames();
+            for (auto& collName : *collNames) {
+                auto coll = src->getCollection(collName);
+                if (coll->getTypeName() == EVENT::LCIO::MCPARTICLE) {
+                    copy->addCollection(copyParticles(coll), collName);
+                }
+            }
+            for (auto& collName : *collNames) {
+                auto coll = src->getCollection(collName);
+                if (coll->getTypeName() != EVENT::LCIO::MCPARTICLE) {
+                    copy->addCollection(copyHits(coll), collName);
+                }
+            }
+            return copy;
+        }
+
+        /**
+         * Copy a collection of MCParticle objects, including their parent relations.
+         */
+        IMPL::LCCollectionVec* copyParticles(EVENT::LCCollection* coll) {
+            auto copyColl = new IMPL::LCCollectionVec(coll->getTypeName());
+            copyColl->setFlag(coll->getFlag());
+            copyColl->reserve(coll->getNumberOfElements());
+            for (int iElem = 0; iElem < coll->getNumberOfElements(); iElem++) {
+                auto p = static_cast<EVENT::MCParticle*>(coll->getElementAt(iElem));
+                auto copyP = new IMPL::MCParticleImpl;
+                copyP->setPDG(p->getPDG());
+                copyP->setGeneratorStatus(p->getGeneratorStatus());
+                copyP->setSimulatorStatus(p->getSimulatorStatus());
+                copyP->setVertex(p->getVertex());
+                copyP->setEndpoint(p->getEndpoint());
+                copyP->setMomentum(p->getMomentum());
+                copyP->setMomentumAtEndpoint(p->getMomentumAtEndpoint());
+                copyP->setMass(p->getMass());
+                copyP->setCharge(p->getCharge());
+                copyP->setTime(p->getTime());
+                copyP->setSpin(p->getSpin());
+                copyP->setColorFlow(p->getColorFlow());
+                particleCopies_[p] = copyP;
+                copyColl->push_back(copyP);
+            }
+            for (int iElem = 0; iElem < coll->getNumberOfElements(); iElem++) {
+                auto p = static_cast<EVENT::MCParticle*>(coll->getElementAt(iElem));
+                auto copyP = particleCopies_[p];
+                for (auto parent : p->getParents()) {
+                    copyP->addParent(getParticleCopy(parent));
+                }
+            }
+            return copyColl;
+        }
+
+        /**
+         * Copy a collection of SimTrackerHit or SimCalorimeterHit objects.
+         */
+        IMPL::LCCollectionVec* copyHits(EVENT::LCCollection* coll) {
+            auto copyColl = new IMPL::LCCollectionVec(coll->getTypeName());
+            copyColl->setFlag(coll->getFlag());
+            copyColl->reserve(coll->getNumberOfElements());
+            bool isCal = coll->getTypeName() == EVENT::LCIO::SIMCALORIMETERHIT;
+            for (int iElem = 0; iElem < coll->getNumberOfElements(); iElem++) {
+                if (isCal) {
+                    auto hit = static_cast<EVENT::SimCalorimeterHit*>(coll->getElementAt(iElem));
+                    auto copyHit = new IMPL::SimCalorimeterHitImpl;
+                    copyHit->setCellID0(hit->getCellID0());
+                    copyHit->setCellID1(hit->getCellID1());
+                    copyHit->setPosition(hit->getPosition());
+                    int nContrib = hit->getNMCContributions();
+                    for (int iContrib = 0; iContrib < nContrib; iContrib++) {
+                        const float* stepPos = hit->getStepPosition(iContrib);
+                        float pos[3] = {stepPos[0], stepPos[1], stepPos[2]};
+                        copyHit->addMCParticleContribution(
+                                getParticleCopy(hit->getParticleCont(iContrib)),
+                                hit->getEnergyCont(iContrib),
+                                hit->getTimeCont(iContrib),
+                                hit->getPDGCont(iContrib),
+                                pos);
+                    }
+                    copyColl->push_back(copyHit);
+                } else {
+                    auto hit = static_cast<EVENT::SimTrackerHit*>(coll->getElementAt(iElem));
+                    auto copyHit = new IMPL::SimTrackerHitImpl;
+                    copyHit->setCellID0(hit->getCellID0());
+                    copyHit->setCellID1(hit->getCellID1());
+                    copyHit->setPosition(hit->getPosition());
+                    copyHit->setEDep(hit->getEDep());
+                    copyHit->setTime(hit->getTime());
+                    copyHit->setMomentum(hit->getMomentum());
+                    copyHit->setPathLength(hit->getPathLength());
+                    copyHit->setMCParticle(getParticleCopy(hit->getMCParticle()));
+                    copyColl->push_back(copyHit);
+                }
+            }
+            return copyColl;
+        }
+
+        /**
+         * Get the copy of a pooled MCParticle, or the particle itself if its collection
+         * was not copied.
+         */
+        EVENT::MCParticle* getParticleCopy(EVENT::MCParticle* p) {
+            if (!p) {
+                return nullptr;
+            }
+            auto it = particleCopies_.find(p);
+            return it != particleCopies_.end() ? it->second : p;
+        }
+
         /**
          * Apply event filters to an input LCIO event, rejecting events that are not accepted
          * by all filters.
@@ -312,6 +765,59 @@ class LcioMergeTool {
             return true;
         }
 
+        /**
+         * Apply event filters to an index entry, rejecting entries that are not accepted
+         * by all filters.
+         */
+        bool accept(const LcioEventIndex::Entry& entry, const std::vector<MergeFilter*>& filters) {
+            for (MergeFilter* filter : filters) {
+                if (!filter->accept(*index_, entry)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Read the next source event that passes the filters, using the index to skip
+         * over rejected events without reading them.
+         */
+        EVENT::LCEvent* readNextIndexedEvent() {
+            auto& entries = index_->getEntries();
+            for (;;) {
+                size_t next = position_;
+                while (next < entries.size() && !accept(entries[next], filters_)) {
+                    ++next;
+                }
+                if (next >= entries.size()) {
+                    break;
+                }
+                if (next > position_) {
+                    if (verbose_ > 2) {
+                        std::cout << "LcioMergeTool: Skipping " << (next - position_)
+                                << " events rejected by index of '" << getName() << "'" << std::endl;
+                    }
+                    reader_->skipNEvents(next - position_);
+                }
+                position_ = next + 1;
+                auto event = reader_->readNextEvent(EVENT::LCIO::UPDATE);
+                if (!event) {
+                    break;
+                }
+                if (event->getEventNumber() != entries[next].event) {
+                    std::cerr << "LcioMergeTool: Read event " << event->getEventNumber() << " but expected "
+                            << entries[next].event << " from index of '" << getName() << "'" << std::endl;
+                }
+                // filters which cannot use the index are applied to the event itself
+                if (accept(event, filters_)) {
+                    return event;
+                }
+            }
+            std::cerr << "LcioMergeTool: No more events to merge from '" << getName() << "'" << std::endl;
+            G4Exception("LcioMergeTool::readNextIndexedEvent", "", RunMustBeAborted, "No more events to merge.");
+            return nullptr;
+        }
+
         /**
          * Returns true if event filters request to skip this output event.
          */
@@ -325,56 +831,75 @@ class LcioMergeTool {
         }
 
         /**
-         * Add all elements from one collection to another.
+         * Move all elements from one collection to another, leaving the source collection empty.
+         *
+         * @note When the source is an LCCollectionVec the element pointers are spliced
+         * into the target in bulk, or the vectors are swapped if the target is empty.
          */
         void addElements(EVENT::LCCollection* src, IMPL::LCCollectionVec* target) {
-            for (int iElem = 0; iElem < src->getNumberOfElements(); iElem++) {
-                target->addElement(src->getElementAt(iElem));
+            auto srcVec = dynamic_cast<IMPL::LCCollectionVec*>(src);
+            if (srcVec) {
+                if (target->empty()) {
+                    target->swap(*srcVec);
+                } else {
+                    target->reserve(target->size() + srcVec->size());
+                    target->insert(target->end(), srcVec->begin(), srcVec->end());
+                    srcVec->clear();
+                }
+            } else {
+                for (int iElem = 0; iElem < src->getNumberOfElements(); iElem++) {
+                    target->addElement(src->getElementAt(iElem));
+                }
+                clear(src);
             }
         }
 
         /**
          * Combine all SimCalorimeterHit objects with the same cell IDs into a single set of hits.
+         *
+         * @note This is done in a single pass over the hits using an open addressing hash table
+         * keyed by the 64-bit cell ID.  The input hits are deleted after their contributions
+         * have been added to the combined hits, so mergeEvent() does not merge LCRelation
+         * collections from or to SimCalorimeterHits while combining is enabled.
          */
         void combine(IMPL::LCCollectionVec* hits) {
 
-            // create a list with combined hits
-            std::set<CellID> processedHits;
-            auto combinedColl = std::vector<EVENT::SimCalorimeterHit*>();
-            for (int iElem = 0; iElem < hits->getNumberOfElements(); iElem++) {
-                EVENT::SimCalorimeterHit* hit =
-                        static_cast<EVENT::SimCalorimeterHit*>(hits->getElementAt(iElem));
-                CellID id = CellID(hit->getCellID0(), hit->getCellID1());
-                if (processedHits.find(id) == processedHits.end()) {
-                    auto foundHits = find(hit, hits);
-                    IMPL::SimCalorimeterHitImpl* combinedHit = createSingleHit(foundHits);
-                    combinedColl.push_back(combinedHit);
-                    processedHits.insert(id);
-                }
+            // size the table to a power of two that is at least twice the number of hits
+            size_t nbits = 4;
+            while (((size_t) 1 << nbits) < 2 * hits->size()) {
+                ++nbits;
             }
+            size_t mask = ((size_t) 1 << nbits) - 1;
+            cellIDs_.assign(mask + 1, 0);
+            slots_.assign(mask + 1, -1);
+            combinedHits_.clear();
+            combinedHits_.reserve(hits->size());
+
+            for (auto elem : *hits) {
+                EVENT::SimCalorimeterHit* hit = static_cast<EVENT::SimCalorimeterHit*>(elem);
+                CellID id = ((CellID) (uint32_t) hit->getCellID1() << 32) | (uint32_t) hit->getCellID0();
+
+                // find the slot for this cell ID using linear probing
+                size_t slot = (id * 0x9E3779B97F4A7C15ULL) >> (64 - nbits);
+                while (slots_[slot] != -1 && cellIDs_[slot] != id) {
+                    slot = (slot + 1) & mask;
+                }
 
-            // clear the old collection
-            clear(hits);
-
-            // add combined hits back to the collection
-            for (auto hit : combinedColl) {
-                hits->addElement(hit);
-            }
-        }
+                // create a combined hit the first time a cell ID is seen
+                IMPL::SimCalorimeterHitImpl* combinedHit = nullptr;
+                if (slots_[slot] == -1) {
+                    combinedHit = new IMPL::SimCalorimeterHitImpl;
+                    combinedHit->setCellID0(hit->getCellID0());
+                    combinedHit->setCellID1(hit->getCellID1());
+                    combinedHit->setPosition(hit->getPosition());
+                    cellIDs_[slot] = id;
+                    slots_[slot] = combinedHits_.size();
+                    combinedHits_.push_back(combinedHit);
+                } else {
+                    combinedHit = static_cast<IMPL::SimCalorimeterHitImpl*>(combinedHits_[slots_[slot]]);
+                }
 
-        /**
-         * Create a single hit from a list of input hits that have the same cell IDs.
-         */
-        IMPL::SimCalorimeterHitImpl* createSingleHit(const std::vector<EVENT::SimCalorimeterHit*>& hits) {
-            if (!hits.size()) {
-                G4Exception("LcioMergeTool::combine", "", FatalException, "Hit vector is empty.");
-            }
-            auto combinedHit = new IMPL::SimCalorimeterHitImpl;
-            auto firstHit = hits.at(0);
-            combinedHit->setCellID0(firstHit->getCellID0());
-            combinedHit->setCellID1(firstHit->getCellID1());
-            combinedHit->setPosition(firstHit->getPosition());
-            for (auto hit : hits) {
+                // accumulate the contributions into the combined hit
                 int nContrib = hit->getNMCContributions();
                 for (int iContrib = 0; iContrib < nContrib; iContrib++) {
                     combinedHit->addMCParticleContribution(
@@ -383,22 +908,14 @@ class LcioMergeTool {
                             hit->getTimeCont(iContrib),
                             hit->getPDGCont(iContrib));
                 }
-            }
-            return combinedHit;
-        }
 
-        /**
-         * Find hits matching a cell ID of a hit.
-         */
-        std::vector<EVENT::SimCalorimeterHit*> find(EVENT::SimCalorimeterHit* searchHit, EVENT::LCCollection* coll) {
-            std::vector<EVENT::SimCalorimeterHit*> foundHits;
-            for (int iElem = 0; iElem < coll->getNumberOfElements(); iElem++) {
-                EVENT::SimCalorimeterHit* hit = static_cast<EVENT::SimCalorimeterHit*>(coll->getElementAt(iElem));
-                if (searchHit->getCellID0() == hit->getCellID0() && searchHit->getCellID1() == hit->getCellID1()) {
-                    foundHits.push_back(hit);
-                }
+                // the input hit is owned by the collection so delete it
+                delete hit;
             }
-            return foundHits;
+
+            // replace the input hits with the combined hits
+            hits->swap(combinedHits_);
+            combinedHits_.clear();
         }
 
     private:
@@ -408,8 +925,38 @@ class LcioMergeTool {
         IO::LCReader* reader_{nullptr};
         std::vector<std::string> files_;
         std::vector<MergeFilter*> filters_;
+        std::vector<std::string> collections_;
+        std::vector<std::string> readCollections_;
         bool combineCalHits_{true};
+        bool useIndex_{false};
+        std::string indexDir_;
+        LcioEventIndex* index_{nullptr};
+        size_t position_{0};
         int verbose_{1};
+
+        /*
+         * In-memory pool of source events which are copied into target events.
+         */
+        size_t poolSize_{0};
+        PoolSampling poolSampling_{Cyclic};
+        bool poolReservoir_{false};
+        std::vector<IMPL::LCEventImpl*> pool_;
+        size_t poolNext_{0};
+        std::unordered_map<EVENT::MCParticle*, IMPL::MCParticleImpl*> particleCopies_;
+
+        /*
+         * Cached names of source collections to merge and the write list they were made from.
+         */
+        std::vector<std::string> mergeCollNames_;
+        std::vector<std::string> cachedWriteColls_;
+        bool mergeCollsCached_{false};
+
+        /*
+         * Working storage for combining hits, which is kept between events.
+         */
+        std::vector<CellID> cellIDs_;
+        std::vector<int> slots_;
+        std::vector<EVENT::LCObject*> combinedHits_;
 };
 
 }
@@ -0,0 +1,218 @@
+#ifndef HPSSIM_LCIOOBJECTPOOL_H_
+#define HPSSIM_LCIOOBJECTPOOL_H_
+
+/*
+ * LCIO
+ */
+#include "IMPL/LCCollectionVec.h"
+#include "IMPL/MCParticleImpl.h"
+#include "IMPL/SimCalorimeterHitImpl.h"
+#include "IMPL/SimTrackerHitImpl.h"
+
+/*
+ * C++
+ */
+#include <string>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @class LcioObjectPool
+ * @brief Pool of LCIO objects which are reused from one event to the next
+ *
+ * @note
+ * The pool owns all of its objects.  Objects handed out by get() during an
+ * event are reset and handed out again after recycle() is called, so they
+ * must not be deleted by anyone else, e.g. by a collection that owns them.
+ * The pool is not thread safe, so each thread should use its own pool.
+ */
+template<class T>
+class LcioObjectPool {
+
+    public:
+
+        virtual ~LcioObjectPool() {
+            for (auto object : objects_) {
+                delete object;
+            }
+        }
+
+        /**
+         * Get a reset object from the pool, creating a new one if all are in use.
+         */
+        T* get() {
+            if (next_ < objects_.size()) {
+                T* object = objects_[next_++];
+                object->reset();
+                return object;
+            }
+            T* object = new T;
+            objects_.push_back(object);
+            ++next_;
+            return object;
+        }
+
+        /**
+         * Make all objects of the pool available again.
+         */
+        void recycle() {
+            next_ = 0;
+        }
+
+        /**
+         * Get the number of objects owned by the pool.
+         */
+        size_t size() const {
+            return objects_.size();
+        }
+
+    private:
+
+        std::vector<T*> objects_;
+        size_t next_{0};
+};
+
+/**
+ * @class PooledMCParticle
+ * @brief MCParticle that can be reset for reuse by an LcioObjectPool
+ */
+class PooledMCParticle : public IMPL::MCParticleImpl {
+
+    public:
+
+        void reset() {
+            setReadOnly(false);
+            _parents.clear();
+            _daughters.clear();
+            static const double zero[3] = {0, 0, 0};
+            static const float zeroSpin[3] = {0, 0, 0};
+            static const int zeroColorFlow[2] = {0, 0};
+            setPDG(0);
+            setGeneratorStatus(0);
+            setSimulatorStatus(0);
+            setVertex(zero);
+            setEndpoint(zero);
+            setMomentum(zero);
+            setMomentumAtEndpoint(zero);
+            setMass(0);
+            setCharge(0);
+            setTime(0);
+            setSpin(zeroSpin);
+            setColorFlow(zeroColorFlow);
+        }
+};
+
+/**
+ * @class PooledSimTrackerHit
+ * @brief SimTrackerHit that can be reset for reuse by an LcioObjectPool
+ */
+class PooledSimTrackerHit : public IMPL::SimTrackerHitImpl {
+
+    public:
+
+        void reset() {
+            setReadOnly(false);
+            static const double zero[3] = {0, 0, 0};
+            setCellID0(0);
+            setCellID1(0);
+            setPosition(zero);
+            setMomentum(0, 0, 0);
+            setPathLength(0);
+            setEDep(0);
+            setTime(0);
+            setMCParticle(nullptr);
+        }
+};
+
+/**
+ * @class PooledSimCalorimeterHit
+ * @brief SimCalorimeterHit that can be reset for reuse by an LcioObjectPool
+ *
+ * @note The MC contribution objects are kept when the hit is reset and are
+ * filled again by addContribution, so the contribution vector and its
+ * capacity are reused as well.
+ */
+class PooledSimCalorimeterHit : public IMPL::SimCalorimeterHitImpl {
+
+    public:
+
+        virtual ~PooledSimCalorimeterHit() {
+            for (auto contrib : spare_) {
+                delete contrib;
+            }
+        }
+
+        void reset() {
+            setReadOnly(false);
+            static const float zero[3] = {0, 0, 0};
+            setCellID0(0);
+            setCellID1(0);
+            setEnergy(0);
+            setPosition(zero);
+            spare_.insert(spare_.end(), _vec.begin(), _vec.end());
+            _vec.clear();
+        }
+
+        /**
+         * Add an MC contribution, reusing a contribution object from a previous event if possible.
+         */
+        void addContribution(EVENT::MCParticle* p, float energy, float time, int pdg, float* stepPosition) {
+            if (spare_.empty()) {
+                addMCParticleContribution(p, energy, time, pdg, stepPosition);
+                return;
+            }
+            IMPL::MCParticleCont* contrib = spare_.back();
+            spare_.pop_back();
+            contrib->Particle = p;
+            contrib->Energy = energy;
+            contrib->Time = time;
+            contrib->PDG = pdg;
+            for (int i = 0; i < 3; i++) {
+                contrib->StepPosition[i] = stepPosition ? stepPosition[i] : 0;
+            }
+            _energy += energy;
+            _vec.push_back(contrib);
+        }
+
+    private:
+
+        std::vector<IMPL::MCParticleCont*> spare_;
+};
+
+/**
+ * @class PooledHitsCollection
+ * @brief Output collection of one hits collection ID with the pools of its hits
+ */
+struct PooledHitsCollection {
+
+    PooledHitsCollection(const std::string& typeName) {
+        collVec = new IMPL::LCCollectionVec(typeName);
+    }
+
+    /**
+     * Delete the collection, which is always empty between events because
+     * its hits are owned by the pools.
+     */
+    ~PooledHitsCollection() {
+        collVec->clear();
+        delete collVec;
+    }
+
+    /**
+     * Empty the collection without deleting its hits and make the hits available again.
+     */
+    void recycle() {
+        collVec->clear();
+        trackerHits.recycle();
+        calHits.recycle();
+    }
+
+    IMPL::LCCollectionVec* collVec;
+    LcioObjectPool<PooledSimTrackerHit> trackerHits;
+    LcioObjectPool<PooledSimCalorimeterHit> calHits;
+};
+
+}
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef HPSSIM_LCIOOUTPUTSTREAM_H_
+#define HPSSIM_LCIOOUTPUTSTREAM_H_
+
+/*
+ * LCIO
+ */
+#include "EVENT/LCIO.h"
+#include "IMPL/LCEventImpl.h"
+#include "IMPL/LCRunHeaderImpl.h"
+#include "IO/LCWriter.h"
+#include "IOIMPL/LCFactory.h"
+
+/*
+ * C++
+ */
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+ * HPS
+ */
+#include "LcioOutputStreamMessenger.h"
+#include "StoreFilter.h"
+
+namespace hpssim {
+
+/**
+ * @class LcioOutputStream
+ * @brief Named LCIO output file which receives the events accepted by its filters
+ *
+ * @note
+ * The LcioPersistencyManager routes every stored event to the first stream whose
+ * filters all accept it, or to its main output file if no stream accepts it.
+ * A stream can leave out collections to write thinner events than the main output.
+ */
+class LcioOutputStream {
+
+    public:
+
+        LcioOutputStream(std::string name) : name_(name) {
+            fileName_ = name + ".slcio";
+            messenger_ = new LcioOutputStreamMessenger(this);
+        }
+
+        virtual ~LcioOutputStream() {
+            if (writer_) {
+                delete writer_;
+            }
+            for (auto filter : filters_) {
+                delete filter;
+            }
+            delete messenger_;
+        }
+
+        const std::string& getName() {
+            return name_;
+        }
+
+        void setFileName(std::string fileName) {
+            fileName_ = fileName;
+        }
+
+        void setVerbose(int verbose) {
+            verbose_ = verbose;
+        }
+
+        /**
+         * Add a filter which must accept an event for it to be written to this stream.
+         * The stream takes ownership of the filter.
+         */
+        void addFilter(StoreFilter* filter) {
+            filters_.push_back(filter);
+        }
+
+        /**
+         * Add a collection which is not written to this stream.
+         * If the MCParticle collection is dropped then the sim hit collections are
+         * dropped too, because their MCParticle references could not be resolved.
+         */
+        void addDropCollection(std::string collName) {
+            dropColls_.push_back(collName);
+        }
+
+        /**
+         * Open the output file at the beginning of the run.
+         * @param writeMode The LCIO write mode or -1 to write a new file.
+         * @param compressionLevel The compression level or -1 for the LCIO default.
+         */
+        void open(int writeMode, int compressionLevel, const std::string& detectorName, int runNumber) {
+            if (verbose_ > 1) {
+                std::cout << "LcioOutputStream: Opening '" << fileName_ << "' for stream '" << name_ << "'" << std::endl;
+            }
+            for (auto filter : filters_) {
+                filter->initialize();
+            }
+            if (!writer_) {
+                writer_ = IOIMPL::LCFactory::getInstance()->createLCWriter();
+            }
+            if (compressionLevel >= 0) {
+                writer_->setCompressionLevel(compressionLevel);
+            }
+            try {
+                if (writeMode < 0) {
+                    writer_->open(fileName_);
+                } else {
+                    writer_->open(fileName_, writeMode);
+                }
+            } catch (IO::IOException& e) {
+                G4Exception("LcioOutputStream::open", "FileExists", RunMustBeAborted, e.what());
+            }
+            IMPL::LCRunHeaderImpl runHeader;
+            runHeader.setDetectorName(detectorName);
+            runHeader.setRunNumber(runNumber);
+            runHeader.setDescription("HPS MC events for stream " + name_);
+            writer_->writeRunHeader(&runHeader);
+            nEvents_ = 0;
+        }
+
+        /**
+         * Return true if all filters of the stream accept the event.
+         */
+        bool accept(const G4Event* anEvent) {
+            for (auto filter : filters_) {
+                if (!filter->accept(anEvent)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Write an event without the dropped collections.
+         */
+        void write(IMPL::LCEventImpl* event) {
+            auto collNames = event->getCollectionNames();
+            bool dropParticles = std::find(dropColls_.begin(), dropColls_.end(), EVENT::LCIO::MCPARTICLE) != dropColls_.end();
+            std::vector<EVENT::LCCollection*> dropped;
+            for (auto& collName : *collNames) {
+                auto coll = event->getCollection(collName);
+                bool drop = std::find(dropColls_.begin(), dropColls_.end(), collName) != dropColls_.end();
+                if (dropParticles && (coll->getTypeName() == EVENT::LCIO::SIMTRACKERHIT
+                        || coll->getTypeName() == EVENT::LCIO::SIMCALORIMETERHIT)) {
+                    drop = true;
+                }
+                if (drop && !coll->isTransient()) {
+                    coll->setTransient(true);
+                    dropped.push_back(coll);
+                }
+            }
+            writer_->writeEvent(static_cast<EVENT::LCEvent*>(event));
+            writer_->flush();
+            for (auto coll : dropped) {
+                coll->setTransient(false);
+            }
+            ++nEvents_;
+        }
+
+        /**
+         * Close the output file at the end of the run.
+         */
+        void close() {
+            writer_->close();
+            if (verbose_ > 0) {
+                std::cout << "LcioOutputStream: Wrote " << nEvents_ << " events to stream '" << name_ << "'" << std::endl;
+            }
+        }
+
+    private:
+
+        std::string name_;
+        std::string fileName_;
+        int verbose_{1};
+
+        LcioOutputStreamMessenger* messenger_;
+        IO::LCWriter* writer_{nullptr};
+
+        std::vector<StoreFilter*> filters_;
+        std::vector<std::string> dropColls_;
+
+        long nEvents_{0};
+};
+
+}
+
+#endif
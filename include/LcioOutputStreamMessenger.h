@@ -0,0 +1,35 @@
+#ifndef HPSSIM_LCIOOUTPUTSTREAMMESSENGER_H_
+#define HPSSIM_LCIOOUTPUTSTREAMMESSENGER_H_
+
+#include "G4UImessenger.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithAString.hh"
+
+namespace hpssim {
+
+class LcioOutputStream;
+
+class LcioOutputStreamMessenger : public G4UImessenger {
+
+    public:
+
+        LcioOutputStreamMessenger(LcioOutputStream* stream);
+
+        void SetNewValue(G4UIcommand* command, G4String newValues);
+
+    private:
+
+        LcioOutputStream* stream_;
+
+        G4UIdirectory* streamDir_;
+
+        G4UIcmdWithAString* fileCmd_;
+        G4UIcmdWithAString* dropCmd_;
+        G4UIcmdWithAnInteger* primaryPDGCmd_;
+        G4UIcommand* minHitsCmd_;
+        G4UIcommand* minEnergyCmd_;
+};
+
+}
+
+#endif
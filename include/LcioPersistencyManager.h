@@ -37,14 +37,30 @@
 /*
  * HPS
  */
+#include "ColumnarOutput.h"
+#include "EcalTriggerFilter.h"
+#include "LcioCollectionSorter.h"
+#include "LcioDigitizer.h"
 #include "LcioMergeTool.h"
+#include "LcioObjectPool.h"
+#include "LcioOutputStream.h"
 #include "LcioPersistencyMessenger.h"
 #include "MCParticleBuilder.h"
+#include "PluginManager.h"
+#include "StoreFilter.h"
+#include "UserTrackingAction.h"
+#include "WorkerPool.h"
 
 /*
  * C++
  */
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdio>
 #include <map>
+#include <sstream>
+#include <vector>
 
 /*
  * LCIO
@@ -73,6 +89,14 @@ class LcioPersistencyManager : public G4PersistencyManager {
             APPEND = LCIO::WRITE_APPEND
         };
 
+        /** How the MC contributions of calorimeter hits are written. */
+        enum CalContribMode {
+            /** Write one contribution per step. */
+            FULL,
+            /** Merge the contributions of each hit per MCParticle and PDG. */
+            COMPACT
+        };
+
         /**
          * Class constructor, which will register this persistency manager as the global default within Geant4.
          */
@@ -82,7 +106,11 @@ class LcioPersistencyManager : public G4PersistencyManager {
             G4PersistencyCenter::GetPersistencyCenter()->SetPersistencyManager(this, "LcioPersistencyManager");
             writer_ = nullptr;
             builder_ = new MCParticleBuilder(UserTrackingAction::getUserTrackingAction()->getTrackMap()); // FIXME: Probably shouldn't set this here!
+            UserTrackingAction::getUserTrackingAction()->setMCParticleBuilder(builder_);
             messenger_ = new LcioPersistencyMessenger(this);
+            trigger_ = new EcalTriggerFilter();
+            digitizer_ = new LcioDigitizer();
+            columnar_ = new ColumnarOutput();
         }
 
         virtual ~LcioPersistencyManager() {
@@ -94,10 +122,25 @@ class LcioPersistencyManager : public G4PersistencyManager {
             delete builder_;
             delete messenger_;
 
+            for (auto pooledColl : pooledColls_) {
+                delete pooledColl;
+            }
+            delete particleColl_;
+
             for (auto entry : merge_) {
                 delete entry.second;
             }
             merge_.clear();
+
+            clearStoreFilters();
+            delete trigger_;
+            delete digitizer_;
+
+            for (auto stream : streams_) {
+                delete stream;
+            }
+
+            delete columnar_;
         }
 
         /**
@@ -110,7 +153,8 @@ class LcioPersistencyManager : public G4PersistencyManager {
         /**
          * Store a Geant4 event to an LCIO output event.
          *
-         * @note Events marked as aborted are skipped and not stored.
+         * @note Events marked as aborted are skipped and not stored, as are events
+         * rejected by the store filters, for which no LCIO objects are created.
          */
         G4bool Store(const G4Event* anEvent) {
             if (!anEvent->IsAborted()) {
@@ -119,6 +163,29 @@ class LcioPersistencyManager : public G4PersistencyManager {
                     std::cout << "LcioPersistencyManager: Storing event " << anEvent->GetEventID() << std::endl;
                 }
 
+                // Apply the event filters before any LCIO objects are created.
+                if (!acceptEvent(anEvent)) {
+                    ++nRejected_;
+                    if (m_verbose > 1) {
+                        std::cout << "LcioPersistencyManager: Event " << anEvent->GetEventID()
+                                << " was rejected by the store filters" << std::endl;
+                    }
+                    return false;
+                }
+
+                // Write the accepted event to the columnar output instead of LCIO if it is selected.
+                if (columnar_->isEnabled()) {
+                    columnar_->write(anEvent, builder_);
+                    return true;
+                }
+
+                // Find the output stream of the event, which is null for the main output.
+                LcioOutputStream* stream = routeEvent(anEvent);
+                if (stream && m_verbose > 1) {
+                    std::cout << "LcioPersistencyManager: Routing event " << anEvent->GetEventID()
+                            << " to stream '" << stream->getName() << "'" << std::endl;
+                }
+
                 // Create new LCIO event.
                 IMPL::LCEventImpl* lcioEvent = new IMPL::LCEventImpl();
                 lcioEvent->setEventNumber(anEvent->GetEventID());
@@ -132,13 +199,26 @@ class LcioPersistencyManager : public G4PersistencyManager {
                 }
 
                 // Write MCParticles to LCIO event (allowed to be empty).
-                auto particleColl = builder_->buildMCParticleColl(anEvent);
+                auto particleColl = builder_->buildMCParticleColl(anEvent, particleColl_);
                 if (m_verbose > 1) {
                     std::cout << "LcioPersistencyManager: Storing " << particleColl->size() << " MC particles in event "
                             << anEvent->GetEventID() << std::endl;
                 }
                 lcioEvent->addCollection(particleColl, EVENT::LCIO::MCPARTICLE);
 
+                // Prune MCParticles which are not needed by the hits (optional).
+                if (builder_->isPrune()) {
+                    markHitTracks(anEvent);
+                    builder_->prune(particleColl);
+                    if (m_verbose > 1) {
+                        std::cout << "LcioPersistencyManager: Kept " << particleColl->size()
+                                << " MC particles after pruning" << std::endl;
+                    }
+                }
+
+                // Resolve the MCParticle of every track so hits can be converted concurrently.
+                builder_->resolveAncestors();
+
                 // Write hits collections to LCIO event.
                 writeHitsCollections(anEvent, lcioEvent);
 
@@ -153,9 +233,37 @@ class LcioPersistencyManager : public G4PersistencyManager {
                     }
                 }
 
-                // Write event and flush writer.
-                writer_->writeEvent(static_cast<EVENT::LCEvent*>(lcioEvent));
-                writer_->flush();
+                // Order the MCParticles and hits for locality, including merged ones (optional).
+                if (sortOutput_) {
+                    sorter_.sort(lcioEvent);
+                }
+
+                // Digitize the sim hits, including merged ones, into readout-level collections (optional).
+                if (digitizer_->isEnabled()) {
+                    digitizer_->digitize(lcioEvent);
+                }
+
+                // Write event to its output stream, or else write it to the main output and flush writer.
+                if (stream) {
+                    stream->write(lcioEvent);
+                } else {
+
+                    // Continue in the next output file if the last one is full (optional),
+                    // which is only opened when there is an event for it.
+                    if (fileFull_) {
+                        ++fileNumber_;
+                        openWriter();
+                    }
+
+                    writer_->writeEvent(static_cast<EVENT::LCEvent*>(lcioEvent));
+                    writer_->flush();
+
+                    ++fileEvents_;
+                    if (isFileFull()) {
+                        writer_->close();
+                        fileFull_ = true;
+                    }
+                }
 
                 // Print final number of objects in collections, including those added by merging LCIO files.
                 if (m_verbose > 1) {
@@ -173,6 +281,9 @@ class LcioPersistencyManager : public G4PersistencyManager {
                 // Dump event information (optional).
                 dumpEvent(lcioEvent);
 
+                // Take back the recycled collections before the event deletes them.
+                recycleCollections(anEvent, lcioEvent);
+
                 // Delete the event object to avoid memory leak.
                 delete lcioEvent;
 
@@ -194,7 +305,30 @@ class LcioPersistencyManager : public G4PersistencyManager {
                 std::cout << "LcioPersistencyManager: Store run " << aRun->GetRunID() << std::endl;
             }
 
-            writer_->close();
+            if (m_verbose > 0 && nRejected_ > 0) {
+                std::cout << "LcioPersistencyManager: Store filters rejected " << nRejected_
+                        << " events in run " << aRun->GetRunID() << std::endl;
+            }
+            if (m_verbose > 0) {
+                trigger_->printSummary();
+            }
+
+            workers_.stop();
+
+            // The columnar output stays open for the next run.
+            if (columnar_->isEnabled()) {
+                columnar_->endRun(aRun);
+                return true;
+            }
+
+            // A full file was closed already after its last event.
+            if (!fileFull_) {
+                writer_->close();
+            }
+
+            for (auto stream : streams_) {
+                stream->close();
+            }
 
             return true;
         }
@@ -213,28 +347,63 @@ class LcioPersistencyManager : public G4PersistencyManager {
                 std::cout << "LcioPersistencyManager: Initializing the persistency manager" << std::endl;
             }
 
-            // Open output writer with configured mode.
-            if (m_verbose > 1) {
-                std::cout << "LcioPersistencyManager: Opening '" << outputFile_
-                        << "' with mode " << modeToString(writeMode_) << std::endl;
-            }
-            writer_ = IOIMPL::LCFactory::getInstance()->createLCWriter();
-            try {
-                if (writeMode_ == NEW) {
-                    writer_->open(outputFile_);
-                } else {
-                    writer_->open(outputFile_, writeMode_);
+            if (columnar_->isEnabled()) {
+
+                // These operate on the LCIO events, which are not made for the columnar output.
+                if (merge_.size() || streams_.size() || digitizer_->isEnabled()) {
+                    G4Exception("LcioPersistencyManager::Initialize()", "", RunMustBeAborted,
+                            "Merging, digitization and output streams are not supported with the columnar output format.");
                 }
-            } catch (IO::IOException& e) {
-                G4Exception("LcioPersistencyManager::Initialize()", "FileExists", RunMustBeAborted, e.what());
+                columnar_->open();
+
+            } else {
+
+                // Open output writer with configured mode, numbering the files when they are rolled over.
+                fileNumber_ = 0;
+                if (rolloverEvents_ > 0 || rolloverBytes_ > 0) {
+                    fileNumber_ = 1;
+                }
+                openWriter();
+
+                // Open the additional output streams.
+                for (auto stream : streams_) {
+                    stream->setVerbose(m_verbose);
+                    stream->open(writeMode_, compressionLevel_, LCDDProcessor::instance()->getDetectorName(),
+                            G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID());
+                }
+
+                // Start the workers for converting hits collections, which help the main thread.
+                workers_.start(conversionThreads_ - 1);
             }
 
-            // Create run header and write to beginning of output file.
-            auto runHeader = new IMPL::LCRunHeaderImpl();
-            runHeader->setDetectorName(LCDDProcessor::instance()->getDetectorName());
-            runHeader->setRunNumber(G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID());
-            runHeader->setDescription("HPS MC events");
-            writer_->writeRunHeader(static_cast<EVENT::LCRunHeader*>(runHeader));
+            // Resolve the hits collection types again for this run.
+            hitsTypes_.clear();
+
+            // Reset the store filters, which look up their collections again.
+            for (auto filter : filters_) {
+                filter->initialize();
+            }
+            trigger_->initialize();
+            nRejected_ = 0;
+
+            // Set up recycling of LCIO objects, which is not possible when merging
+            // because the merge tools move hits between collections and delete them.
+            bool recycle = recycle_ && merge_.empty();
+            if (recycle_ && !recycle) {
+                std::cerr << "LcioPersistencyManager: LCIO objects are not recycled when merging events" << std::endl;
+            }
+            if (recycle && !particleColl_) {
+                particleColl_ = new IMPL::LCCollectionVec(EVENT::LCIO::MCPARTICLE);
+                builder_->setObjectPool(&particlePool_);
+            } else if (!recycle && particleColl_) {
+                builder_->setObjectPool(nullptr);
+                delete particleColl_;
+                particleColl_ = nullptr;
+                for (auto pooledColl : pooledColls_) {
+                    delete pooledColl;
+                }
+                pooledColls_.clear();
+            }
 
             // Initialize file merge tools.
             for (auto entry : merge_) {
@@ -254,6 +423,110 @@ class LcioPersistencyManager : public G4PersistencyManager {
             outputFile_ = outputFile;
         }
 
+        /**
+         * Set the number of events after which the output continues in a new file,
+         * or zero to write all events into one file.
+         */
+        void setRolloverEvents(int rolloverEvents) {
+            rolloverEvents_ = rolloverEvents;
+        }
+
+        /**
+         * Set the file size in bytes after which the output continues in a new file,
+         * or zero for no size limit.
+         */
+        void setRolloverBytes(long rolloverBytes) {
+            rolloverBytes_ = rolloverBytes;
+        }
+
+        /**
+         * Set the compression level of the LCIO output files from 0 (no compression)
+         * to 9 (best compression), or -1 to use the LCIO default.
+         */
+        void setCompressionLevel(int compressionLevel) {
+            compressionLevel_ = compressionLevel;
+        }
+
+        /**
+         * Set whether MCParticles should be built incrementally at the end of tracking,
+         * which releases the Trajectory objects during event processing.
+         *
+         * @note Trajectories are not available for visualization in this mode.
+         */
+        void setIncremental(bool incremental) {
+            builder_->setIncremental(incremental);
+        }
+
+        /**
+         * Set the number of threads used to convert hits collections to LCIO.
+         * One thread converts the collections serially in the calling thread.
+         */
+        void setConversionThreads(int conversionThreads) {
+            conversionThreads_ = conversionThreads > 0 ? conversionThreads : 1;
+        }
+
+        /**
+         * Set whether the MCParticle collection is pruned to the particles needed by the hits.
+         */
+        void setPrune(bool prune) {
+            builder_->setPrune(prune);
+        }
+
+        /**
+         * Set the minimum energy of MCParticles referenced by hits which are kept when pruning.
+         */
+        void setPruneMinEnergy(double pruneMinEnergy) {
+            builder_->setPruneMinEnergy(pruneMinEnergy);
+        }
+
+        /**
+         * Add a PDG code of MCParticles referenced by hits which are always kept when pruning.
+         */
+        void addPruneKeepPDG(int pdg) {
+            builder_->addPruneKeepPDG(pdg);
+        }
+
+        /**
+         * Add a filter which must accept an event for it to be stored.
+         * The persistency manager takes ownership of the filter.
+         */
+        void addStoreFilter(StoreFilter* filter) {
+            filters_.push_back(filter);
+        }
+
+        /**
+         * Delete all store filters.
+         */
+        void clearStoreFilters() {
+            for (auto filter : filters_) {
+                delete filter;
+            }
+            filters_.clear();
+        }
+
+        /**
+         * Set how the MC contributions of calorimeter hits are written.
+         */
+        void setCalContribMode(CalContribMode calContribMode) {
+            calContribMode_ = calContribMode;
+        }
+
+        /**
+         * Set whether LCIO collections, MCParticles and hits are reused between events
+         * instead of being allocated for every event.
+         */
+        void setRecycle(bool recycle) {
+            recycle_ = recycle;
+        }
+
+        /**
+         * Set whether MCParticles are written in depth-first ancestry order and
+         * hits are sorted by cell ID and time.
+         */
+        void setSortOutput(bool sortOutput) {
+            sortOutput_ = sortOutput;
+        }
+
         /**
          * Set the WriteMode of the LCIO writer.
          */
@@ -288,6 +561,14 @@ class LcioPersistencyManager : public G4PersistencyManager {
             merge_[merge->getName()] = merge;
         }
 
+        /**
+         * Add an output stream which receives the events accepted by its filters.
+         * Streams are checked in the order they were added.
+         */
+        void addStream(LcioOutputStream* stream) {
+            streams_.push_back(stream);
+        }
+
         /**
          * Get the named merge configuration.
          */
@@ -343,59 +624,322 @@ class LcioPersistencyManager : public G4PersistencyManager {
 
     private:
 
+        /** Type of a hits collection to convert. */
+        enum HitsCollectionType {
+            UNRESOLVED,
+            TRACKER_HITS,
+            CALORIMETER_HITS
+        };
+
+        /**
+         * Sum of the MC contributions to a calorimeter hit from one MCParticle and PDG,
+         * with the earliest time and the energy weighted position.
+         */
+        struct CompactContribution {
+            IMPL::MCParticleImpl* mcp;
+            int pdg;
+            float edep;
+            float time;
+            float pos[3];
+            float weightedPos[3];
+        };
+
+        /**
+         * A hits collection from the Geant4 event and its converted LCIO collection,
+         * with the messages and the error of the conversion which are printed and
+         * raised from the main thread.
+         */
+        struct HitsConversion {
+            G4VHitsCollection* hc;
+            HitsCollectionType type;
+            IMPL::LCCollectionVec* collVec;
+            PooledHitsCollection* pool;
+            std::string log;
+            std::string error;
+        };
+
         /**
          * Write hits collections from the Geant4 event to an LCIO event.
+         *
+         * @note The collections are independent of each other, so when more than one
+         * conversion thread is configured they are converted concurrently by the
+         * worker pool, one collection at a time per thread.  MCParticles are looked
+         * up read only from the table which the builder resolved before this is called.
+         * The workers do not print or raise exceptions; their messages and errors are
+         * handled here after all collections are converted.
          */
         void writeHitsCollections(const G4Event* g4Event, IMPL::LCEventImpl* lcioEvent) {
             G4HCofThisEvent* hce = g4Event->GetHCofThisEvent();
             if (hce) {
                 int nColl = hce->GetNumberOfCollections();
 
+                // Get the converter and the recycled output collection for each collection ID.
+                hitsColls_.clear();
                 for (int iColl = 0; iColl < nColl; iColl++) {
-
                     G4VHitsCollection* hc = hce->GetHC(iColl);
-                    std::string collName = hc->GetName();
-                    LCCollectionVec* collVec = nullptr;
+                    HitsCollectionType type = getHitsCollectionType(iColl, hc);
+                    PooledHitsCollection* pool = nullptr;
+                    if (particleColl_) {
+                        if (iColl >= (int) pooledColls_.size()) {
+                            pooledColls_.resize(iColl + 1, nullptr);
+                        }
+                        if (!pooledColls_[iColl]) {
+                            pooledColls_[iColl] = new PooledHitsCollection(
+                                    type == TRACKER_HITS ? LCIO::SIMTRACKERHIT : LCIO::SIMCALORIMETERHIT);
+                        }
+                        pool = pooledColls_[iColl];
+                    }
+                    hitsColls_.push_back(HitsConversion{hc, type, nullptr, pool, "", ""});
+                }
 
-                    if (dynamic_cast<TrackerHitsCollection*>(hc)) {
-                        collVec = writeTrackerHitsCollection(hc);
-                    } else if (dynamic_cast<CalorimeterHitsCollection*>(hc)) {
-                        collVec = writeCalorimeterHitsCollection(hc);
-                    } else {
-                        std::cerr << "Hits collection '" << collName << "' has unknown type." << std::endl;
+                // Convert the collections, using the worker threads if there is more than one collection.
+                if (hitsColls_.size() > 1 && workers_.getNumberOfWorkers() > 0) {
+                    workers_.run(hitsColls_.size(), [this](int iColl) {
+                        convertHitsCollection(hitsColls_[iColl]);
+                    });
+                } else {
+                    for (auto& hitsColl : hitsColls_) {
+                        convertHitsCollection(hitsColl);
+                    }
+                }
+
+                // Print the conversion messages and raise the first error.
+                for (auto& hitsColl : hitsColls_) {
+                    std::cout << hitsColl.log;
+                    if (hitsColl.error.size()) {
+                        std::cerr << "LcioPersistencyManager: " << hitsColl.error << std::endl;
                         G4Exception("LcioPersistencyManager::writeHitsCollections", "", FatalException,
-                                "Unknown hit type.");
+                                hitsColl.error.c_str());
                     }
+                }
 
-                    if (collVec) {
-                        lcioEvent->addCollection(collVec, collName);
-                        if (m_verbose > 1) {
-                            std::cout << "LcioPersistencyManager: Stored " << collVec->size()
-                                    << " hits in '" << collName << "'" << std::endl;
+                // Add the collections to the event in their original order.
+                for (auto& hitsColl : hitsColls_) {
+                    std::string collName = hitsColl.hc->GetName();
+                    lcioEvent->addCollection(hitsColl.collVec, collName);
+                    if (m_verbose > 1) {
+                        std::cout << "LcioPersistencyManager: Stored " << hitsColl.collVec->size()
+                                << " hits in '" << collName << "'" << std::endl;
+                    }
+                }
+                hitsColls_.clear();
+            }
+        }
+
+        /**
+         * Convert one hits collection to LCIO according to its type.
+         */
+        void convertHitsCollection(HitsConversion& hitsColl) {
+            std::ostringstream log;
+            try {
+                if (hitsColl.type == TRACKER_HITS) {
+                    hitsColl.collVec = writeTrackerHitsCollection(hitsColl.hc, hitsColl.pool, log, hitsColl.error);
+                } else {
+                    hitsColl.collVec = writeCalorimeterHitsCollection(hitsColl.hc, hitsColl.pool, log, hitsColl.error);
+                }
+            } catch (std::exception& e) {
+                hitsColl.error = "Error converting '" + hitsColl.hc->GetName() + "': " + e.what();
+            }
+            hitsColl.log = log.str();
+        }
+
+        /**
+         * Get the type of the hits collection with this ID, which is resolved
+         * once per run from the first collection with the ID.
+         */
+        HitsCollectionType getHitsCollectionType(int collID, G4VHitsCollection* hc) {
+            if (collID >= (int) hitsTypes_.size()) {
+                hitsTypes_.resize(collID + 1, UNRESOLVED);
+            }
+            if (hitsTypes_[collID] == UNRESOLVED) {
+                if (dynamic_cast<TrackerHitsCollection*>(hc)) {
+                    hitsTypes_[collID] = TRACKER_HITS;
+                } else if (dynamic_cast<CalorimeterHitsCollection*>(hc)) {
+                    hitsTypes_[collID] = CALORIMETER_HITS;
+                } else {
+                    std::cerr << "Hits collection '" << hc->GetName() << "' has unknown type." << std::endl;
+                    G4Exception("LcioPersistencyManager::writeHitsCollections", "", FatalException,
+                            "Unknown hit type.");
+                }
+            }
+            return hitsTypes_[collID];
+        }
+
+        /**
+         * Get the name of the current output file, which is numbered as in
+         * "name_0001.slcio" when the output is rolled over.
+         */
+        std::string getFileName() {
+            if (fileNumber_ == 0) {
+                return outputFile_;
+            }
+            std::string base = outputFile_;
+            std::string ext;
+            size_t dot = base.rfind(".");
+            if (dot != std::string::npos && base.find("/", dot) == std::string::npos) {
+                ext = base.substr(dot);
+                base = base.substr(0, dot);
+            }
+            char number[16];
+            snprintf(number, sizeof(number), "_%04d", fileNumber_);
+            return base + number + ext;
+        }
+
+        /**
+         * Open the writer for the current output file and write the run header to it.
+         */
+        void openWriter() {
+            std::string fileName = getFileName();
+            if (m_verbose > 1 || (m_verbose > 0 && fileNumber_ > 1)) {
+                std::cout << "LcioPersistencyManager: Opening '" << fileName
+                        << "' with mode " << modeToString(writeMode_) << std::endl;
+            }
+            if (writer_) {
+                delete writer_;
+            }
+            writer_ = IOIMPL::LCFactory::getInstance()->createLCWriter();
+            if (compressionLevel_ >= 0) {
+                writer_->setCompressionLevel(compressionLevel_);
+            }
+            try {
+                if (writeMode_ == NEW) {
+                    writer_->open(fileName);
+                } else {
+                    writer_->open(fileName, writeMode_);
+                }
+            } catch (IO::IOException& e) {
+                G4Exception("LcioPersistencyManager::openWriter()", "FileExists", RunMustBeAborted, e.what());
+            }
+            fileEvents_ = 0;
+            fileFull_ = false;
+
+            // Create run header and write to beginning of output file.
+            auto runHeader = new IMPL::LCRunHeaderImpl();
+            runHeader->setDetectorName(LCDDProcessor::instance()->getDetectorName());
+            runHeader->setRunNumber(G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID());
+            runHeader->setDescription("HPS MC events");
+            writer_->writeRunHeader(static_cast<EVENT::LCRunHeader*>(runHeader));
+            delete runHeader;
+        }
+
+        /**
+         * Check whether the current output file has reached the rollover event count or size.
+         *
+         * @note The size is that of the file on disk after the writer was flushed, so it is
+         * approximate and a file can be larger than the limit by up to one event.
+         */
+        bool isFileFull() {
+            if (rolloverEvents_ > 0 && fileEvents_ >= rolloverEvents_) {
+                return true;
+            }
+            if (rolloverBytes_ > 0) {
+                struct stat fileStat;
+                if (stat(getFileName().c_str(), &fileStat) == 0 && fileStat.st_size >= rolloverBytes_) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Get the first output stream which accepts the event, or null if the event
+         * should be written to the main output file.
+         */
+        LcioOutputStream* routeEvent(const G4Event* g4Event) {
+            for (auto stream : streams_) {
+                if (stream->accept(g4Event)) {
+                    return stream;
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * Check whether an event passes all store filters, the ECal trigger and the filter plugins.
+         */
+        bool acceptEvent(const G4Event* g4Event) {
+            for (auto filter : filters_) {
+                if (!filter->accept(g4Event)) {
+                    return false;
+                }
+            }
+            if (!trigger_->accept(g4Event)) {
+                return false;
+            }
+            return PluginManager::getPluginManager()->acceptEvent(g4Event);
+        }
+
+        /**
+         * Mark the tracks referenced by the hits of the event for pruning the MCParticles.
+         */
+        void markHitTracks(const G4Event* g4Event) {
+            G4HCofThisEvent* hce = g4Event->GetHCofThisEvent();
+            if (!hce) {
+                return;
+            }
+            for (int iColl = 0; iColl < hce->GetNumberOfCollections(); iColl++) {
+                G4VHitsCollection* hc = hce->GetHC(iColl);
+                if (getHitsCollectionType(iColl, hc) == TRACKER_HITS) {
+                    auto trackerHits = static_cast<TrackerHitsCollection*>(hc);
+                    for (int i = 0; i < (int) trackerHits->GetSize(); i++) {
+                        builder_->markReferenced(static_cast<TrackerHit*>(trackerHits->GetHit(i))->getTrackID());
+                    }
+                } else {
+                    auto calHits = static_cast<CalorimeterHitsCollection*>(hc);
+                    for (int i = 0; i < (int) calHits->GetSize(); i++) {
+                        const auto& contribs = static_cast<CalorimeterHit*>(calHits->GetHit(i))->getHitContributions();
+                        for (auto& contrib : contribs) {
+                            builder_->markReferenced(contrib.getTrackID());
                         }
                     }
                 }
             }
         }
 
+        /**
+         * Take the recycled collections back from the event after it was written and
+         * empty them, so that the event does not delete them or the pooled objects.
+         */
+        void recycleCollections(const G4Event* g4Event, IMPL::LCEventImpl* lcioEvent) {
+            if (!particleColl_) {
+                return;
+            }
+            lcioEvent->takeCollection(LCIO::MCPARTICLE);
+            particleColl_->clear();
+            G4HCofThisEvent* hce = g4Event->GetHCofThisEvent();
+            for (int iColl = 0; iColl < (int) pooledColls_.size(); iColl++) {
+                if (pooledColls_[iColl] && hce && iColl < hce->GetNumberOfCollections()) {
+                    lcioEvent->takeCollection(hce->GetHC(iColl)->GetName());
+                    pooledColls_[iColl]->recycle();
+                }
+            }
+        }
+
         /**
          * Write a TrackerHitsCollection (LCDD) to LCIO.
+         * Messages are written to the log and the conversion stops at the first error.
          */
-        IMPL::LCCollectionVec* writeTrackerHitsCollection(G4VHitsCollection* hc) {
-            auto trackerHits = dynamic_cast<TrackerHitsCollection*>(hc);
-            auto collVec = new LCCollectionVec(LCIO::SIMTRACKERHIT);
+        IMPL::LCCollectionVec* writeTrackerHitsCollection(G4VHitsCollection* hc, PooledHitsCollection* pool,
+                std::ostream& log, std::string& error) {
+            auto trackerHits = static_cast<TrackerHitsCollection*>(hc);
+            auto collVec = pool ? pool->collVec : new LCCollectionVec(LCIO::SIMTRACKERHIT);
             IMPL::LCFlagImpl collFlag;
             collFlag.setBit(EVENT::LCIO::THBIT_MOMENTUM);
             collVec->setFlag(collFlag.getFlag());
 
             int nhits = trackerHits->GetSize();
             if (m_verbose > 2) {
-                std::cout << "LcioPersistencyManager: Converting " << nhits << " tracker hits to LCIO" << std::endl;
+                log << "LcioPersistencyManager: Converting " << nhits << " tracker hits to LCIO" << std::endl;
             }
             for (int i = 0; i < nhits; i++) {
 
                 auto trackerHit = static_cast<TrackerHit*>(trackerHits->GetHit(i));
-                auto simTrackerHit = new IMPL::SimTrackerHitImpl();
+                IMPL::SimTrackerHitImpl* simTrackerHit = nullptr;
+                if (pool) {
+                    simTrackerHit = pool->trackerHits.get();
+                } else {
+                    simTrackerHit = new IMPL::SimTrackerHitImpl();
+                }
 
                 // position in mm
                 const G4ThreeVector posVec = trackerHit->getPosition();
@@ -423,18 +967,16 @@ class LcioPersistencyManager : public G4PersistencyManager {
 
                 // get the MCParticle for the hit
                 if (m_verbose > 3) {
-                    std::cout << "LcioPersistencyManager: Looking for track ID " << trackerHit->getTrackID()
+                    log << "LcioPersistencyManager: Looking for track ID " << trackerHit->getTrackID()
                             << std::endl;
                 }
-                IMPL::MCParticleImpl* mcp = builder_->findMCParticle(trackerHit->getTrackID());
+                IMPL::MCParticleImpl* mcp = builder_->getMCParticle(trackerHit->getTrackID());
                 if (!mcp) {
-                    std::cerr << "LcioPersistencyManager: No MCParticle found for trackID " << trackerHit->getTrackID()
-                            << " from sim tracker hit" << std::endl;
-                    G4Exception("LcioPersistencyManager::writeHitsCollections", "", FatalException,
-                            "MCParticle for track ID is missing.");
-                } else {
-                    simTrackerHit->setMCParticle(mcp);
+                    error = "No MCParticle found for track ID " + std::to_string(trackerHit->getTrackID())
+                            + " from sim tracker hit in '" + hc->GetName() + "'";
+                    return collVec;
                 }
+                simTrackerHit->setMCParticle(mcp);
             }
             return collVec;
         }
@@ -442,10 +984,11 @@ class LcioPersistencyManager : public G4PersistencyManager {
         /**
          * Write a CalorimeterHitsCollection (LCDD) to LCIO.
          */
-        IMPL::LCCollectionVec* writeCalorimeterHitsCollection(G4VHitsCollection* hc) {
+        IMPL::LCCollectionVec* writeCalorimeterHitsCollection(G4VHitsCollection* hc, PooledHitsCollection* pool,
+                std::ostream& log, std::string& error) {
 
-            auto calHits = dynamic_cast<CalorimeterHitsCollection*>(hc);
-            auto collVec = new LCCollectionVec(LCIO::SIMCALORIMETERHIT);
+            auto calHits = static_cast<CalorimeterHitsCollection*>(hc);
+            auto collVec = pool ? pool->collVec : new LCCollectionVec(LCIO::SIMCALORIMETERHIT);
             IMPL::LCFlagImpl collFlag;
             collFlag.setBit(EVENT::LCIO::CHBIT_LONG);
             collFlag.setBit(EVENT::LCIO::CHBIT_PDG);
@@ -453,12 +996,23 @@ class LcioPersistencyManager : public G4PersistencyManager {
 
             int nhits = calHits->GetSize();
             if (m_verbose > 2) {
-                std::cout << "LcioPersistencyManager: Converting " << nhits << " calorimeter hits to LCIO" << std::endl;
+                log << "LcioPersistencyManager: Converting " << nhits << " calorimeter hits to LCIO" << std::endl;
             }
+
+            // Scratch list of compacted contributions of one hit, which is local to this call
+            // because collections may be converted on several threads.
+            std::vector<CompactContribution> compactContribs;
             for (int i = 0; i < nhits; i++) {
 
                 auto calHit = static_cast<CalorimeterHit*>(calHits->GetHit(i));
-                auto simCalHit = new IMPL::SimCalorimeterHitImpl();
+                PooledSimCalorimeterHit* pooledCalHit = nullptr;
+                IMPL::SimCalorimeterHitImpl* simCalHit = nullptr;
+                if (pool) {
+                    pooledCalHit = pool->calHits.get();
+                    simCalHit = pooledCalHit;
+                } else {
+                    simCalHit = new IMPL::SimCalorimeterHitImpl();
+                }
 
                 // set cellid from cal hit's id64
                 const Id64bit& id64 = calHit->getId64bit();
@@ -476,7 +1030,8 @@ class LcioPersistencyManager : public G4PersistencyManager {
                 // add to output collection
                 collVec->push_back(simCalHit);
 
-                auto contribs = calHit->getHitContributions();
+                const auto& contribs = calHit->getHitContributions();
+                compactContribs.clear();
                 for (auto contrib : contribs) {
                     auto edep = contrib.getEdep();
                     auto hitTime = contrib.getGlobalTime();
@@ -485,31 +1040,48 @@ class LcioPersistencyManager : public G4PersistencyManager {
                     auto trackID = contrib.getTrackID();
 
                     if (trackID <= 0) {
-                        std::cerr << "LcioPersistencyManager: Bad track ID " << trackID << " for calorimeter hit contrib" << std::endl;
-                        G4Exception("LcioPersistencyManager::writeCalorimeterHitsCollections", "",
-                                FatalException, "Bad track ID in cal hit contribution.");
+                        error = "Bad track ID " + std::to_string(trackID) + " for calorimeter hit contrib in '"
+                                + hc->GetName() + "'";
+                        return collVec;
                     }
 
-                    // Find the first parent track with a trajectory; it could actually be this track.
-                    G4VTrajectory* traj = builder_->getTrackMap().findTrajectory(trackID);
-                    if (!traj) {
-                        std::cerr << "LcioPersistencyManager: No trajectory found for track ID " << trackID << std::endl;
-                        G4Exception("LcioPersistencyManager::writeCalorimeterHitsCollections", "",
-                                FatalException, "No trajectory found for track ID.");
-                    }
-
-                    // Lookup an MCParticle from the parent, which should exist!
-                    auto mcp = builder_->findMCParticle(traj->GetTrackID());
+                    // Lookup the MCParticle of the first parent track with a trajectory; it could actually be this track.
+                    auto mcp = builder_->getMCParticle(trackID);
                     if (!mcp) {
-                        std::cerr << "LcioPersistencyManager: No MCParticle found for track ID " << trackID << std::endl;
-                        G4Exception("LcioPersistencyManager::writeCalorimeterHitsCollection", "",
-                                FatalException, "No MCParticle found for track ID.");
+                        if (!builder_->getTrackMap().hasTrajectoryInParentage(trackID)) {
+                            error = "No trajectory found for track ID " + std::to_string(trackID);
+                        } else {
+                            error = "No MCParticle found for track ID " + std::to_string(trackID);
+                        }
+                        error += " from calorimeter hit contrib in '" + hc->GetName() + "'";
+                        return collVec;
                     }
 
-                    simCalHit->addMCParticleContribution(static_cast<EVENT::MCParticle*>(mcp), (float)edep, (float)hitTime, (int)pdg, (float*)contribPos);
+                    // In compact mode accumulate the contributions per MCParticle and PDG.
+                    if (calContribMode_ == COMPACT) {
+                        CompactContribution* compact = nullptr;
+                        for (auto& compactContrib : compactContribs) {
+                            if (compactContrib.mcp == mcp && compactContrib.pdg == pdg) {
+                                compact = &compactContrib;
+                                break;
+                            }
+                        }
+                        if (!compact) {
+                            compactContribs.push_back(CompactContribution{mcp, (int)pdg, 0, (float)hitTime,
+                                {(float)contribPos[0], (float)contribPos[1], (float)contribPos[2]}, {0, 0, 0}});
+                            compact = &compactContribs.back();
+                        }
+                        compact->edep += edep;
+                        compact->time = std::min(compact->time, (float)hitTime);
+                        for (int iPos = 0; iPos < 3; iPos++) {
+                            compact->weightedPos[iPos] += edep * contribPos[iPos];
+                        }
+                    } else {
+                        addCalContribution(simCalHit, pooledCalHit, mcp, (float)edep, (float)hitTime, (int)pdg, (float*)contribPos);
+                    }
 
                     if (m_verbose > 3) {
-                        std::cout << "LcioPersistencyManager: Assigned hit contrib with "
+                        log << "LcioPersistencyManager: Assigned hit contrib with "
                                 << "trackID = " << trackID << "; "
                                 << "edep = " << edep << "; "
                                 << "time = " << hitTime << "; "
@@ -518,10 +1090,37 @@ class LcioPersistencyManager : public G4PersistencyManager {
                                 << std::endl;
                     }
                 }
+
+                // Add the compacted contributions with their energy weighted positions.
+                for (auto& compact : compactContribs) {
+                    if (compact.edep > 0) {
+                        for (int iPos = 0; iPos < 3; iPos++) {
+                            compact.pos[iPos] = compact.weightedPos[iPos] / compact.edep;
+                        }
+                    }
+                    addCalContribution(simCalHit, pooledCalHit, compact.mcp, compact.edep, compact.time, compact.pdg, compact.pos);
+                }
             }
             return collVec;
         }
 
+        /**
+         * Add an MC contribution to a calorimeter hit, which may be a pooled hit.
+         */
+        static void addCalContribution(IMPL::SimCalorimeterHitImpl* simCalHit,
+                PooledSimCalorimeterHit* pooledCalHit,
+                IMPL::MCParticleImpl* mcp,
+                float edep,
+                float time,
+                int pdg,
+                float* pos) {
+            if (pooledCalHit) {
+                pooledCalHit->addContribution(static_cast<EVENT::MCParticle*>(mcp), edep, time, pdg, pos);
+            } else {
+                simCalHit->addMCParticleContribution(static_cast<EVENT::MCParticle*>(mcp), edep, time, pdg, pos);
+            }
+        }
+
         /**
          * Dump an event summary and/or detailed information depending on the
          * current flag settings.
@@ -555,6 +1154,75 @@ class LcioPersistencyManager : public G4PersistencyManager {
         /** LCIO files to merge into every Geant4 event (optional). */
         std::map<std::string, LcioMergeTool*> merge_;
 
+        /** Number of events per output file, or zero for no limit. */
+        int rolloverEvents_{0};
+
+        /** Size in bytes of an output file after which a new one is started, or zero for no limit. */
+        long rolloverBytes_{0};
+
+        /** Compression level of the output files, or -1 for the LCIO default. */
+        int compressionLevel_{-1};
+
+        /** Number of the current output file, which is zero if the output is not rolled over. */
+        int fileNumber_{0};
+
+        /** Number of events written to the current output file. */
+        int fileEvents_{0};
+
+        /** Flag set when the current output file was closed because it is full. */
+        bool fileFull_{false};
+
+        /** Additional output streams, which get the events accepted by their filters. */
+        std::vector<LcioOutputStream*> streams_;
+
+        /** Filters which must accept an event for it to be stored. */
+        std::vector<StoreFilter*> filters_;
+
+        /** ECal trigger emulation, which accepts all events unless it is enabled. */
+        EcalTriggerFilter* trigger_;
+
+        /** Digitization of the sim hits, which is only applied if collections are configured. */
+        LcioDigitizer* digitizer_;
+
+        /** Columnar output, which replaces the LCIO output if it is enabled. */
+        ColumnarOutput* columnar_;
+
+        /** Number of events rejected by the store filters in the current run. */
+        int nRejected_{0};
+
+        /** Hits collections of the current event being converted. */
+        std::vector<HitsConversion> hitsColls_;
+
+        /** Number of threads used to convert hits collections. */
+        int conversionThreads_{1};
+
+        /** Worker threads for converting hits collections, which are started for each run. */
+        WorkerPool workers_;
+
+        /** Type of each hits collection ID, resolved once per run. */
+        std::vector<HitsCollectionType> hitsTypes_;
+
+        /** How calorimeter hit MC contributions are written. */
+        CalContribMode calContribMode_{FULL};
+
+        /** Flag to reuse LCIO objects between events. */
+        bool recycle_{false};
+
+        /** Flag to order the output collections for locality. */
+        bool sortOutput_{false};
+
+        /** Sorts the output collections, reusing its buffers between events. */
+        LcioCollectionSorter sorter_;
+
+        /** Pool of MCParticles which are reused between events. */
+        LcioObjectPool<PooledMCParticle> particlePool_;
+
+        /** Recycled MCParticle collection, which is null if objects are not recycled. */
+        IMPL::LCCollectionVec* particleColl_{nullptr};
+
+        /** Recycled hits collections and their hits by collection ID. */
+        std::vector<PooledHitsCollection*> pooledColls_;
+
         /** Flag to dump collection summary info after writing an event. */
         bool dumpEventSummary_{false};
 
@@ -5,6 +5,7 @@
 #include "G4UIcmdWithAString.hh"
 #include "G4UIcmdWithAnInteger.hh"
 #include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
 
 namespace hpssim {
 
@@ -44,6 +45,9 @@ class LcioPersistencyMessenger : public G4UImessenger {
         G4UIcommand* appendCmd_;
         G4UIcommand* recreateCmd_;
 
+        /** Compression level of the output files. */
+        G4UIcmdWithAnInteger* compressionCmd_;
+
         /*
          * Merge tool commands.
          */
@@ -58,6 +62,50 @@ class LcioPersistencyMessenger : public G4UImessenger {
 
         /** Dump file. */
         G4UIcommand* dumpFileCmd_;
+
+        /** Build MCParticles incrementally at the end of tracking. */
+        G4UIcmdWithABool* incrementalCmd_;
+
+        /** Number of threads for converting hits collections. */
+        G4UIcmdWithAnInteger* threadsCmd_;
+
+        /** Reuse LCIO objects between events. */
+        G4UIcmdWithABool* recycleCmd_;
+
+        /** Order the output collections for locality. */
+        G4UIcmdWithABool* sortOutputCmd_;
+
+        /** Set how calorimeter hit MC contributions are written. */
+        G4UIcmdWithAString* calContribCmd_;
+
+        /*
+         * MCParticle pruning commands.
+         */
+        G4UIdirectory* pruneDir_;
+        G4UIcmdWithABool* pruneEnableCmd_;
+        G4UIcmdWithADoubleAndUnit* pruneMinEnergyCmd_;
+        G4UIcmdWithAnInteger* pruneKeepPDGCmd_;
+
+        /*
+         * Store filter commands.
+         */
+        G4UIdirectory* filterDir_;
+        G4UIcommand* filterMinHitsCmd_;
+        G4UIcommand* filterMinEnergyCmd_;
+        G4UIcommand* filterClearCmd_;
+
+        /*
+         * Output file rollover commands.
+         */
+        G4UIdirectory* rolloverDir_;
+        G4UIcmdWithAnInteger* rolloverEventsCmd_;
+        G4UIcmdWithAnInteger* rolloverMegabytesCmd_;
+
+        /*
+         * Output stream commands.
+         */
+        G4UIdirectory* streamDir_;
+        G4UIcmdWithAString* streamAddCmd_;
 };
 
 }
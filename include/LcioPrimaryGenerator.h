@@ -107,6 +107,13 @@ class LcioPrimaryGenerator : public PrimaryGenerator {
             return true;
         }
 
+        /**
+         * Add a collection to read from the input files in addition to the MCParticle collection.
+         */
+        void addReadCollection(std::string collName) {
+            readCollections_.push_back(collName);
+        }
+
         bool supportsRandomAccess() {
             return true;
         }
@@ -144,6 +151,7 @@ class LcioPrimaryGenerator : public PrimaryGenerator {
                 delete reader_;
             }
             reader_ = IOIMPL::LCFactory::getInstance()->createLCReader(IO::LCReader::directAccess);
+            reader_->setReadCollectionNames(readCollections_);
             reader_->open(file);
             runHeader_ = reader_->readNextRunHeader(); // FIXME: Hope there isn't more than one of these in the file!
             if (!runHeader_) {
@@ -192,6 +200,9 @@ class LcioPrimaryGenerator : public PrimaryGenerator {
 
         /** List of event indices that is used for random access via the reader. */
         std::vector<long> events_;
+
+        /** Names of the collections to read from the input files; others are skipped. */
+        std::vector<std::string> readCollections_{"MCParticle"};
 };
 
 }
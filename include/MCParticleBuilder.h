@@ -1,8 +1,9 @@
 #ifndef HPSSIM_MCPARTICLEBUILDER_H_
 #define HPSSIM_MCPARTICLEBUILDER_H_
 
+#include "LcioObjectPool.h"
+#include "TrackMap.h"
 #include "Trajectory.h"
-#include "UserTrackingAction.h"
 
 #include "EVENT/LCIO.h"
 #include "IMPL/MCParticleImpl.h"
@@ -10,40 +11,326 @@
 
 #include "G4SystemOfUnits.hh"
 
-#include <map>
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <vector>
 
 namespace hpssim {
 
+/**
+ * @class MCParticleBuilder
+ * @brief Builds the output MCParticle collection from saved trajectories
+ *
+ * @note
+ * By default all MCParticles are built at the end of the event from the
+ * Trajectory objects in the event's trajectory container.  In incremental
+ * mode, each saved track is instead converted to an MCParticle by the
+ * UserTrackingAction as soon as it has finished tracking, so that its
+ * Trajectory can be deleted right away.  Parents are linked when the
+ * collection is built at the end of the event.
+ *
+ * Optionally, the collection can be pruned so that it only contains the
+ * MCParticles referenced by hits, their ancestors and the generator
+ * particles.  Hits of pruned MCParticles are assigned to the nearest
+ * ancestor which is kept.
+ */
 class MCParticleBuilder {
 
     public:
 
-        typedef std::map<G4int, IMPL::MCParticleImpl*> MCParticleMap;
+        /**
+         * Dense list of MCParticles indexed by track ID.
+         */
+        typedef std::vector<IMPL::MCParticleImpl*> MCParticleMap;
+
+        /**
+         * Pair of track ID and parent track ID.
+         */
+        typedef std::pair<G4int, G4int> ParentLink;
 
         MCParticleBuilder(TrackMap* trackMap) : trackMap_(trackMap) {
         }
 
         virtual ~MCParticleBuilder() {
+            clear();
         }
 
-        void buildParticleMap(G4TrajectoryContainer* trajectories, IMPL::LCCollectionVec* collVec) {
-            particleMap_.clear();
-            for (auto trajectory : *trajectories->GetVector()) {
-                if (Trajectory::getTrajectory(trajectory)->getSaveFlag()) {
-                    auto particle = new IMPL::MCParticleImpl;
-                    collVec->addElement(particle);
-                    particleMap_[trajectory->GetTrackID()] = particle;
+        /**
+         * Set whether MCParticles are built incrementally at the end of tracking.
+         */
+        void setIncremental(bool incremental) {
+            incremental_ = incremental;
+        }
+
+        /**
+         * Get whether MCParticles are built incrementally at the end of tracking.
+         */
+        bool isIncremental() {
+            return incremental_;
+        }
+
+        /**
+         * Set a pool from which MCParticles are taken instead of allocating them,
+         * or null to allocate them.  The pool is recycled by clear().
+         */
+        void setObjectPool(LcioObjectPool<PooledMCParticle>* pool) {
+            clear();
+            pool_ = pool;
+        }
+
+        /**
+         * Return true if the MCParticles are owned by an object pool instead of their collection.
+         */
+        bool hasObjectPool() {
+            return pool_ != nullptr;
+        }
+
+        /**
+         * Set whether the MCParticle collection is pruned with prune().
+         */
+        void setPrune(bool prune) {
+            prune_ = prune;
+        }
+
+        bool isPrune() {
+            return prune_;
+        }
+
+        /**
+         * Set the minimum energy of an MCParticle referenced by hits to be kept when pruning.
+         */
+        void setPruneMinEnergy(double pruneMinEnergy) {
+            pruneMinEnergy_ = pruneMinEnergy;
+        }
+
+        /**
+         * Add a PDG code of MCParticles referenced by hits which are kept when pruning
+         * regardless of their energy.
+         */
+        void addPruneKeepPDG(int pdg) {
+            pruneKeepPDGs_.push_back(pdg);
+        }
+
+        /**
+         * Mark a track as referenced by a hit for pruning.
+         */
+        void markReferenced(G4int trackID) {
+            if (trackID < 0) {
+                return;
+            }
+            if (trackID >= (G4int) referenced_.size()) {
+                referenced_.resize(std::max(trackMap_->size(), trackID + 1), false);
+            }
+            referenced_[trackID] = true;
+        }
+
+        /**
+         * Prune the MCParticle collection and link the parents of the kept MCParticles.
+         *
+         * @note An MCParticle is kept if it has no saved parent, if it is a generator
+         * particle, or if it is referenced by a hit and passes the keep rules.  All
+         * ancestors of kept MCParticles are kept too.  Afterwards, every track ID
+         * resolves to the nearest kept MCParticle via getMCParticle().  Track IDs
+         * are always larger than the IDs of their parents, so each step is one pass.
+         */
+        void prune(IMPL::LCCollectionVec* collVec) {
+
+            G4int n = trackMap_->size();
+            particleMap_.resize(n, nullptr);
+            referenced_.resize(n, false);
+
+            // Find the nearest saved ancestor of every track, including the track itself.
+            savedAncestors_.assign(n, -1);
+            for (G4int trackID = 1; trackID < n; trackID++) {
+                if (particleMap_[trackID]) {
+                    savedAncestors_[trackID] = trackID;
+                } else if (!trackMap_->hasTrajectory(trackID)) {
+                    G4int parentID = trackMap_->getParentID(trackID);
+                    if (parentID > 0 && parentID < trackID) {
+                        savedAncestors_[trackID] = savedAncestors_[parentID];
+                    }
+                }
+            }
+
+            // Hits of tracks without their own MCParticle reference their saved ancestor.
+            for (G4int trackID = 1; trackID < n; trackID++) {
+                if (referenced_[trackID] && savedAncestors_[trackID] > 0) {
+                    referenced_[savedAncestors_[trackID]] = true;
+                }
+            }
+
+            // Flag MCParticles which are kept by themselves.
+            kept_.assign(n, false);
+            for (G4int trackID = 1; trackID < n; trackID++) {
+                auto particle = particleMap_[trackID];
+                if (particle) {
+                    kept_[trackID] = getSavedParent(trackID) == -1
+                            || particle->getGeneratorStatus() != 0
+                            || (referenced_[trackID] && passesKeepRules(particle));
+                }
+            }
+
+            // Keep the saved ancestors of kept MCParticles.
+            for (G4int trackID = n - 1; trackID > 0; trackID--) {
+                if (kept_[trackID]) {
+                    G4int parentID = getSavedParent(trackID);
+                    if (parentID > 0) {
+                        kept_[parentID] = true;
+                    }
+                }
+            }
+
+            // Find the nearest kept ancestor of every saved MCParticle.
+            keptAncestors_.assign(n, -1);
+            for (G4int trackID = 1; trackID < n; trackID++) {
+                if (particleMap_[trackID]) {
+                    keptAncestors_[trackID] = kept_[trackID] ? trackID : keptAncestors_[getSavedParent(trackID)];
+                }
+            }
+
+            // Resolve every track ID to its nearest kept MCParticle.
+            ancestorMap_.assign(n, nullptr);
+            resolved_.assign(n, true);
+            for (G4int trackID = 1; trackID < n; trackID++) {
+                G4int savedID = savedAncestors_[trackID];
+                if (savedID > 0) {
+                    ancestorMap_[trackID] = particleMap_[keptAncestors_[savedID]];
+                }
+            }
+
+            // Refill the collection with the kept MCParticles and delete the others.
+            collVec->clear();
+            for (G4int trackID = 1; trackID < n; trackID++) {
+                auto particle = particleMap_[trackID];
+                if (particle) {
+                    if (kept_[trackID]) {
+                        collVec->push_back(particle);
+                    } else {
+                        if (!pool_) {
+                            delete particle;
+                        }
+                        particleMap_[trackID] = nullptr;
+                    }
                 }
             }
+
+            // Link the kept MCParticles to their saved parents, which are all kept.
+            for (auto link : links_) {
+                auto particle = particleMap_[link.first];
+                if (particle) {
+                    G4int parentID = getSavedParent(link.first);
+                    if (parentID > 0) {
+                        particle->addParent(particleMap_[parentID]);
+                    }
+                }
+            }
+            links_.clear();
+            referenced_.assign(referenced_.size(), false);
         }
 
-        IMPL::MCParticleImpl* findMCParticle(G4int trackID) {
-            G4VTrajectory* traj = trackMap_->findTrajectory(trackID);
-            if (traj != nullptr) {
-                return particleMap_[traj->GetTrackID()];
+        /**
+         * Clear the per-event state at the beginning of an event.
+         *
+         * @note Any MCParticles built incrementally for an event that was not
+         * stored (e.g. an aborted event) are deleted here, or returned to the
+         * pool together with those of the last stored event.
+         */
+        void clear() {
+            if (pool_) {
+                pool_->recycle();
             } else {
+                for (auto particle : particles_) {
+                    delete particle;
+                }
+            }
+            particles_.clear();
+            particleMap_.clear();
+            links_.clear();
+            referenced_.assign(referenced_.size(), false);
+        }
+
+        /**
+         * Reset the dense particle and ancestor tables so they can be indexed
+         * by any track ID from the current event.
+         */
+        void resetParticleMap() {
+            particleMap_.assign(trackMap_->size(), nullptr);
+            resetAncestorMap();
+        }
+
+        /**
+         * Reset the memo of track IDs to the MCParticle of their first saved ancestor.
+         */
+        void resetAncestorMap() {
+            ancestorMap_.assign(trackMap_->size(), nullptr);
+            resolved_.assign(trackMap_->size(), false);
+        }
+
+        /**
+         * Find the MCParticle of a track, or of its first ancestor with a saved trajectory.
+         *
+         * @note The result for every track ID visited along the parentage is memoized
+         * for the current event, so repeated lookups from hits are constant time.
+         */
+        IMPL::MCParticleImpl* findMCParticle(G4int trackID) {
+            if (trackID < 0 || trackID >= (G4int) resolved_.size()) {
                 return nullptr;
             }
+
+            // Walk up the parentage until a trajectory or an already resolved track is found.
+            IMPL::MCParticleImpl* particle = nullptr;
+            G4int currTrackID = trackID;
+            visited_.clear();
+            while (currTrackID >= 0 && currTrackID < (G4int) resolved_.size()) {
+                if (resolved_[currTrackID]) {
+                    particle = ancestorMap_[currTrackID];
+                    break;
+                }
+                visited_.push_back(currTrackID);
+                if (trackMap_->hasTrajectory(currTrackID)) {
+                    particle = particleMap_[currTrackID];
+                    break;
+                }
+                currTrackID = trackMap_->getParentID(currTrackID);
+            }
+
+            // Remember the result for every track ID on the path.
+            for (auto visitedID : visited_) {
+                ancestorMap_[visitedID] = particle;
+                resolved_[visitedID] = true;
+            }
+
+            return particle;
+        }
+
+        /**
+         * Resolve the MCParticle of every track ID in the event up front, so that
+         * lookups can be done with getMCParticle from several threads at once.
+         */
+        void resolveAncestors() {
+            if (resolved_.size() < trackMap_->size()) {
+                particleMap_.resize(trackMap_->size(), nullptr);
+                resetAncestorMap();
+            }
+            for (G4int trackID = 0; trackID < (G4int) resolved_.size(); trackID++) {
+                if (!resolved_[trackID]) {
+                    findMCParticle(trackID);
+                }
+            }
+        }
+
+        /**
+         * Get the MCParticle of a track, or of its first ancestor with a saved trajectory,
+         * from the table filled by resolveAncestors.
+         *
+         * @note This is read only so it is safe to call from multiple threads.
+         */
+        IMPL::MCParticleImpl* getMCParticle(G4int trackID) const {
+            if (trackID < 0 || trackID >= (G4int) ancestorMap_.size()) {
+                return nullptr;
+            }
+            return ancestorMap_[trackID];
         }
 
         void buildMCParticle(Trajectory* traj) {
@@ -74,13 +361,6 @@ class MCParticleBuilder {
             double endp[] = {traj->getEndPoint()[0], traj->getEndPoint()[1], traj->getEndPoint()[2]};
             p->setEndpoint(endp);
 
-            if (traj->GetParentID() > 0) {
-                IMPL::MCParticleImpl* parent = findMCParticle(traj->GetParentID());
-                if (parent != nullptr) {
-                    p->addParent(parent);
-                }
-            }
-
             // Set sim status to indicate particle was created in simulation.
             if (!traj->getGenStatus()) {
                 std::bitset<32> simStatus;
@@ -89,21 +369,85 @@ class MCParticleBuilder {
             }
         }
 
-        IMPL::LCCollectionVec* buildMCParticleColl(const G4Event* anEvent) {
+        /**
+         * Build an MCParticle from a finished track's Trajectory in incremental mode.
+         * The Trajectory is not referenced afterwards so it may be deleted.
+         */
+        void addTrajectory(Trajectory* traj) {
+            G4int trackID = traj->GetTrackID();
+            if (trackID >= (G4int) particleMap_.size()) {
+                particleMap_.resize(trackID + 1, nullptr);
+            }
+            auto particle = newMCParticle();
+            particleMap_[trackID] = particle;
+            buildMCParticle(traj);
+            particles_.push_back(particle);
+            links_.push_back(ParentLink(trackID, traj->GetParentID()));
+        }
+
+        /**
+         * Build the MCParticle collection from the saved trajectories in the event.
+         *
+         * @note The trajectory container is only traversed once.  Parents are linked
+         * afterwards, because a parent may appear after its daughter in the container.
+         * In incremental mode the MCParticles have already been built during tracking
+         * and the trajectory container is not used.
+         *
+         * @param collVec An empty collection to fill or null to create a new one.
+         */
+        IMPL::LCCollectionVec* buildMCParticleColl(const G4Event* anEvent, IMPL::LCCollectionVec* collVec = nullptr) {
+
+            if (!collVec) {
+                collVec = new IMPL::LCCollectionVec(EVENT::LCIO::MCPARTICLE);
+            }
+
+            if (incremental_) {
+
+                // Extend the particle map to cover all track IDs and reset the ancestor memo.
+                particleMap_.resize(trackMap_->size(), nullptr);
+                resetAncestorMap();
+
+                // Ownership of the MCParticles is passed to the collection.
+                for (auto particle : particles_) {
+                    collVec->addElement(particle);
+                }
+                particles_.clear();
 
-            auto collVec = new IMPL::LCCollectionVec(EVENT::LCIO::MCPARTICLE);
-            auto trajectories = anEvent->GetTrajectoryContainer();
+            } else {
 
-            if (trajectories) {
+                resetParticleMap();
+                links_.clear();
+
+                auto trajectories = anEvent->GetTrajectoryContainer();
+                if (trajectories) {
+                    for (auto trajectory : *trajectories->GetVector()) {
+                        auto traj = Trajectory::getTrajectory(trajectory);
+                        if (traj->getSaveFlag()) {
+                            auto particle = newMCParticle();
+                            collVec->addElement(particle);
+                            particleMap_[traj->GetTrackID()] = particle;
+                            buildMCParticle(traj);
+                            links_.push_back(ParentLink(traj->GetTrackID(), traj->GetParentID()));
+                        }
+                    }
+                }
+            }
 
-                buildParticleMap(trajectories, collVec);
+            // Parents are linked by prune() when the collection is pruned.
+            if (prune_) {
+                return collVec;
+            }
 
-                for (auto trajectory : *trajectories->GetVector()) {
-                    if (Trajectory::getTrajectory(trajectory)->getSaveFlag()) {
-                        buildMCParticle(static_cast<Trajectory*>(trajectory));
+            // Link MCParticles to the MCParticle of their first saved ancestor.
+            for (auto link : links_) {
+                if (link.second > 0) {
+                    IMPL::MCParticleImpl* parent = findMCParticle(link.second);
+                    if (parent != nullptr) {
+                        particleMap_[link.first]->addParent(parent);
                     }
                 }
             }
+            links_.clear();
 
             return collVec;
         }
@@ -114,8 +458,89 @@ class MCParticleBuilder {
 
     private:
 
+        /**
+         * Get the track ID of the nearest saved ancestor of a saved track, or -1 if there is none.
+         */
+        G4int getSavedParent(G4int trackID) {
+            G4int parentID = trackMap_->getParentID(trackID);
+            if (parentID > 0 && parentID < trackID) {
+                return savedAncestors_[parentID];
+            }
+            return -1;
+        }
+
+        /**
+         * Check the energy and PDG keep rules for pruning.
+         */
+        bool passesKeepRules(IMPL::MCParticleImpl* particle) {
+            if (getEnergy(particle) >= pruneMinEnergy_) {
+                return true;
+            }
+            return std::find(pruneKeepPDGs_.begin(), pruneKeepPDGs_.end(), particle->getPDG()) != pruneKeepPDGs_.end();
+        }
+
+        /**
+         * Get the energy of an MCParticle in Geant4 units.
+         *
+         * @note MCParticleImpl::getEnergy() cannot be used here, because the momentum
+         * is set in GeV but the mass is set in Geant4 units (MeV) by buildMCParticle().
+         */
+        static double getEnergy(IMPL::MCParticleImpl* particle) {
+            const double* p = particle->getMomentum();
+            double mass = particle->getMass() / GeV;
+            return std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2] + mass * mass) * GeV;
+        }
+
+        IMPL::MCParticleImpl* newMCParticle() {
+            if (pool_) {
+                return pool_->get();
+            }
+            return new IMPL::MCParticleImpl;
+        }
+
+    private:
+
+        /** Map of track IDs to MCParticles of saved trajectories. */
         MCParticleMap particleMap_;
 
+        /** Memo of track IDs to the MCParticle of their first saved ancestor. */
+        MCParticleMap ancestorMap_;
+
+        /** Flags indicating which entries of the ancestor memo are valid. */
+        std::vector<bool> resolved_;
+
+        /** Scratch list of track IDs visited while resolving an ancestor. */
+        std::vector<G4int> visited_;
+
+        /** Track and parent IDs of the MCParticles whose parents are not linked yet. */
+        std::vector<ParentLink> links_;
+
+        /** MCParticles built incrementally which are not yet owned by a collection. */
+        std::vector<IMPL::MCParticleImpl*> particles_;
+
+        /** Flag for building MCParticles incrementally at the end of tracking. */
+        bool incremental_{false};
+
+        /** Pool of MCParticles which are reused between events (optional). */
+        LcioObjectPool<PooledMCParticle>* pool_{nullptr};
+
+        /** Flag for pruning the MCParticle collection. */
+        bool prune_{false};
+
+        /** Minimum energy of MCParticles referenced by hits which are kept when pruning. */
+        double pruneMinEnergy_{0};
+
+        /** PDG codes of MCParticles referenced by hits which are always kept when pruning. */
+        std::vector<int> pruneKeepPDGs_;
+
+        /*
+         * Per-event working storage for pruning, indexed by track ID.
+         */
+        std::vector<bool> referenced_;
+        std::vector<bool> kept_;
+        std::vector<G4int> savedAncestors_;
+        std::vector<G4int> keptAncestors_;
+
         TrackMap* trackMap_;
 };
 }
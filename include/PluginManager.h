@@ -103,6 +103,13 @@ class PluginManager {
          */
         void endEvent(const G4Event* anEvent);
 
+        /**
+         * Activate the event filter hook of registered plugins.
+         * @param anEvent The Geant4 event.
+         * @return True if all plugins with a filter action accept the event.
+         */
+        bool acceptEvent(const G4Event* anEvent);
+
         /**
          * Activate the generate primary hook of registered plugins.
          * @param anEvent The Geant4 event.
@@ -294,6 +294,15 @@ class PrimaryGenerator : public G4VPrimaryGenerator {
         virtual void openFile(std::string) {
         }
 
+        /**
+         * File-based generators that can skip unneeded data in their input files
+         * should override this to add the name of a collection to read.
+         */
+        virtual void addReadCollection(std::string) {
+            G4Exception("PrimaryGenerator::addReadCollection", "", FatalException,
+                    G4String("The generator " + getName() + " does not support reading selected collections."));
+        }
+
         /**
          * Generators should use this hook to cleanup event data that needs to be deleted.
          */  
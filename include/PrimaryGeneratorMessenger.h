@@ -42,6 +42,8 @@ class PrimaryGeneratorMessenger : public G4UImessenger {
 
         G4UIcommand* randomCmd_;
         G4UIcommand* sequentialCmd_;
+
+        G4UIcmdWithAString* readCollectionCmd_;
 };
 
 }
@@ -41,7 +41,8 @@ class SimPlugin {
             STACKING,
             STEPPING,
             TRACKING,
-            PRIMARY
+            PRIMARY,
+            FILTER
         };
 
         /**
@@ -140,6 +141,14 @@ class SimPlugin {
         virtual void endEvent(const G4Event*) {
         }
 
+        /**
+         * Event filter action, which is activated before an event is written to the output.
+         * @return False to reject the event so that it is not written.
+         */
+        virtual bool acceptEvent(const G4Event*) {
+            return true;
+        }
+
         /**
          * Generate primary action.
          */
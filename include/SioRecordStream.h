@@ -0,0 +1,276 @@
+/**
+ * @file SioRecordStream.h
+ * @brief Classes for copying raw SIO records between LCIO files
+ */
+
+#ifndef HPSSIM_SIORECORDSTREAM_H_
+#define HPSSIM_SIORECORDSTREAM_H_
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @class SioRecord
+ * @brief One raw record of an SIO file with its header and (possibly compressed) data
+ *
+ * @note
+ * The record header is a list of big-endian 32-bit words: the header length,
+ * the record marker, the options, the length of the data as stored, the
+ * uncompressed length of the data and the length of the record name, followed
+ * by the name which is padded to 4 bytes.  The data are padded to 4 bytes as well.
+ */
+class SioRecord {
+
+    public:
+
+        static const uint32_t RECORD_MARKER = 0xabadcafe;
+        static const uint32_t BLOCK_MARKER = 0xdeadbeef;
+        static const uint32_t OPT_COMPRESS = 0x00000001;
+
+        /** Offset of the run number in the EventHeader and RunHeader blocks. */
+        static const int RUN_NUMBER_OFFSET = 0;
+
+        /** Offset of the event number in the EventHeader block. */
+        static const int EVENT_NUMBER_OFFSET = 4;
+
+        const std::string& getName() const {
+            return name_;
+        }
+
+        bool isCompressed() const {
+            return getWord(header_, 8) & OPT_COMPRESS;
+        }
+
+        /**
+         * Get the total size of the record in bytes.
+         */
+        size_t getSize() const {
+            return header_.size() + data_.size();
+        }
+
+        /**
+         * Overwrite a 32-bit integer in the data of the first block of the record.
+         *
+         * @note Compressed records are inflated, modified and deflated again,
+         * which is cheap for the small header records this is meant for.
+         */
+        void setBlockInt(int offset, int32_t value) {
+            std::vector<char> buffer;
+            uint32_t length = getWord(header_, 16);
+            if (isCompressed()) {
+                buffer.resize(length);
+                uLongf destLen = length;
+                if (uncompress((Bytef*) buffer.data(), &destLen,
+                        (const Bytef*) data_.data(), getWord(header_, 12)) != Z_OK || destLen != length) {
+                    throw std::runtime_error("Failed to uncompress record " + name_);
+                }
+            } else {
+                buffer.assign(data_.begin(), data_.begin() + length);
+            }
+
+            if (buffer.size() < 16 || getWord(buffer, 4) != BLOCK_MARKER) {
+                throw std::runtime_error("Bad block in record " + name_);
+            }
+            size_t blockDataStart = 16 + pad(getWord(buffer, 12));
+            if (blockDataStart + offset + 4 > buffer.size()) {
+                throw std::runtime_error("Block of record " + name_ + " is too short");
+            }
+            setWord(buffer, blockDataStart + offset, (uint32_t) value);
+
+            if (isCompressed()) {
+                uLongf destLen = compressBound(buffer.size());
+                data_.resize(destLen);
+                if (compress2((Bytef*) data_.data(), &destLen,
+                        (const Bytef*) buffer.data(), buffer.size(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+                    throw std::runtime_error("Failed to compress record " + name_);
+                }
+                setWord(header_, 12, destLen);
+                data_.resize(pad(destLen), 0);
+            } else {
+                std::copy(buffer.begin(), buffer.end(), data_.begin());
+            }
+        }
+
+        /**
+         * Read the next record from a stream.
+         * @return False at the end of the stream.
+         */
+        bool read(std::istream& in) {
+            header_.resize(8);
+            if (!in.read(header_.data(), 8)) {
+                return false;
+            }
+            uint32_t headerLength = getWord(header_, 0);
+            if (getWord(header_, 4) != RECORD_MARKER || headerLength < 24) {
+                throw std::runtime_error("Bad SIO record marker");
+            }
+            header_.resize(headerLength);
+            if (!in.read(header_.data() + 8, headerLength - 8)) {
+                throw std::runtime_error("Truncated SIO record header");
+            }
+            uint32_t nameLength = getWord(header_, 20);
+            if (24 + nameLength > headerLength) {
+                throw std::runtime_error("Bad SIO record name length");
+            }
+            name_.assign(header_.data() + 24, nameLength);
+            data_.resize(pad(getWord(header_, 12)));
+            if (!in.read(data_.data(), data_.size())) {
+                throw std::runtime_error("Truncated SIO record " + name_);
+            }
+            return true;
+        }
+
+        /**
+         * Write the record to a stream.
+         */
+        void write(std::ostream& out) const {
+            out.write(header_.data(), header_.size());
+            out.write(data_.data(), data_.size());
+        }
+
+    private:
+
+        static uint32_t pad(uint32_t length) {
+            return (length + 3) & ~3u;
+        }
+
+        static uint32_t getWord(const std::vector<char>& buffer, size_t pos) {
+            const unsigned char* p = (const unsigned char*) buffer.data() + pos;
+            return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+        }
+
+        static void setWord(std::vector<char>& buffer, size_t pos, uint32_t value) {
+            buffer[pos] = (char) (value >> 24);
+            buffer[pos + 1] = (char) (value >> 16);
+            buffer[pos + 2] = (char) (value >> 8);
+            buffer[pos + 3] = (char) value;
+        }
+
+    private:
+
+        std::string name_;
+        std::vector<char> header_;
+        std::vector<char> data_;
+};
+
+/**
+ * @class SioRecordCat
+ * @brief Concatenates LCIO files by copying their SIO records without unpacking events
+ *
+ * @note
+ * Event and run records are copied byte for byte unless the run or event numbers
+ * should be rewritten, in which case only the small header records are modified.
+ * The random access records at the end of each input file are dropped because
+ * their file offsets are no longer valid; LCIO rebuilds them when needed.
+ */
+class SioRecordCat {
+
+    public:
+
+        /**
+         * Set the run number that is written into all run and event headers,
+         * or -1 to keep the original run numbers.
+         */
+        void setRunNumber(int runNumber) {
+            runNumber_ = runNumber;
+        }
+
+        /**
+         * Set the number of the first event to renumber events sequentially,
+         * or -1 to keep the original event numbers.
+         */
+        void setFirstEventNumber(int firstEventNumber) {
+            nextEventNumber_ = firstEventNumber;
+        }
+
+        /**
+         * Set whether only the first run header should be written.
+         */
+        void setSingleRunHeader(bool singleRunHeader) {
+            singleRunHeader_ = singleRunHeader;
+        }
+
+        void setVerbose(int verbose) {
+            verbose_ = verbose;
+        }
+
+        void open(const std::string& fileName) {
+            out_.open(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!out_.is_open()) {
+                throw std::runtime_error("Failed to open output file " + fileName);
+            }
+        }
+
+        /**
+         * Append all records of an input file to the output.
+         */
+        void add(const std::string& fileName) {
+            std::ifstream in(fileName.c_str(), std::ios::in | std::ios::binary);
+            if (!in.is_open()) {
+                throw std::runtime_error("Failed to open input file " + fileName);
+            }
+            if (verbose_ > 0) {
+                std::cout << "SioRecordCat: Adding '" << fileName << "'" << std::endl;
+            }
+            while (record_.read(in)) {
+                const std::string& name = record_.getName();
+                if (name == "LCIORandomAccess" || name == "LCIOIndex") {
+                    continue;
+                } else if (name == "LCRunHeader") {
+                    if (singleRunHeader_ && nRunHeaders_ > 0) {
+                        continue;
+                    }
+                    if (runNumber_ >= 0) {
+                        record_.setBlockInt(SioRecord::RUN_NUMBER_OFFSET, runNumber_);
+                    }
+                    ++nRunHeaders_;
+                } else if (name == "LCEventHeader") {
+                    if (runNumber_ >= 0) {
+                        record_.setBlockInt(SioRecord::RUN_NUMBER_OFFSET, runNumber_);
+                    }
+                    if (nextEventNumber_ >= 0) {
+                        record_.setBlockInt(SioRecord::EVENT_NUMBER_OFFSET, nextEventNumber_++);
+                    }
+                    ++nEvents_;
+                }
+                record_.write(out_);
+                nBytes_ += record_.getSize();
+            }
+        }
+
+        void close() {
+            out_.close();
+            if (verbose_ > 0) {
+                std::cout << "SioRecordCat: Wrote " << nEvents_ << " events in " << nBytes_ << " bytes" << std::endl;
+            }
+        }
+
+        long getNumberOfEvents() const {
+            return nEvents_;
+        }
+
+    private:
+
+        std::ofstream out_;
+        SioRecord record_;
+        int runNumber_{-1};
+        int nextEventNumber_{-1};
+        bool singleRunHeader_{false};
+        int verbose_{1};
+        long nRunHeaders_{0};
+        long nEvents_{0};
+        long nBytes_{0};
+};
+
+}
+
+#endif
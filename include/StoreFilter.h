@@ -0,0 +1,186 @@
+#ifndef HPSSIM_STOREFILTER_H_
+#define HPSSIM_STOREFILTER_H_
+
+/*
+ * LCDD
+ */
+#include "lcdd/hits/CalorimeterHit.hh"
+
+/*
+ * Geant4
+ */
+#include "G4Event.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4SDManager.hh"
+
+/*
+ * C++
+ */
+#include <iostream>
+#include <string>
+
+namespace hpssim {
+
+/**
+ * @class StoreFilter
+ * @brief Decides whether a Geant4 event is written to the output before it is converted
+ *
+ * @note Filters work directly on the hits collections of the Geant4 event,
+ * so rejected events do not need any output objects to be created.
+ */
+class StoreFilter {
+
+    public:
+
+        virtual ~StoreFilter() {
+        }
+
+        /**
+         * Return true if the event should be stored.
+         */
+        virtual bool accept(const G4Event* anEvent) = 0;
+
+        /**
+         * Reset any cached state at the beginning of a run.
+         */
+        virtual void initialize() {
+        }
+};
+
+/**
+ * @class HitsCollectionFilter
+ * @brief Base class for filters which look at one named hits collection
+ *
+ * @note The collection ID is looked up once per run from the name.
+ */
+class HitsCollectionFilter : public StoreFilter {
+
+    public:
+
+        HitsCollectionFilter(std::string collName) : collName_(collName) {
+        }
+
+        void initialize() {
+            collID_ = -2;
+        }
+
+    protected:
+
+        /**
+         * Get the hits collection from the event or null if it does not exist.
+         */
+        G4VHitsCollection* getHitsCollection(const G4Event* anEvent) {
+            if (collID_ == -2) {
+                collID_ = G4SDManager::GetSDMpointer()->GetCollectionID(collName_);
+                if (collID_ < 0) {
+                    std::cerr << "StoreFilter: Hits collection '" << collName_ << "' does not exist" << std::endl;
+                }
+            }
+            G4HCofThisEvent* hce = anEvent->GetHCofThisEvent();
+            if (!hce || collID_ < 0) {
+                return nullptr;
+            }
+            return hce->GetHC(collID_);
+        }
+
+    protected:
+
+        std::string collName_;
+        int collID_{-2};
+};
+
+/**
+ * @class MinHitsFilter
+ * @brief Rejects events with fewer than a minimum number of hits in a collection
+ */
+class MinHitsFilter : public HitsCollectionFilter {
+
+    public:
+
+        MinHitsFilter(std::string collName, int minHits) : HitsCollectionFilter(collName), minHits_(minHits) {
+        }
+
+        bool accept(const G4Event* anEvent) {
+            auto hc = getHitsCollection(anEvent);
+            int nHits = hc ? (int) hc->GetSize() : 0;
+            return nHits >= minHits_;
+        }
+
+    private:
+
+        int minHits_;
+};
+
+/**
+ * @class MinEnergyFilter
+ * @brief Rejects events with less than a minimum energy deposition in a calorimeter hits collection
+ */
+class MinEnergyFilter : public HitsCollectionFilter {
+
+    public:
+
+        MinEnergyFilter(std::string collName, double minEnergy) : HitsCollectionFilter(collName), minEnergy_(minEnergy) {
+        }
+
+        bool accept(const G4Event* anEvent) {
+            auto calHits = dynamic_cast<CalorimeterHitsCollection*>(getHitsCollection(anEvent));
+            if (!calHits) {
+                return false;
+            }
+            double energy = 0;
+            for (int i = 0; i < (int) calHits->GetSize(); i++) {
+                energy += static_cast<CalorimeterHit*>(calHits->GetHit(i))->getEdep();
+                if (energy >= minEnergy_) {
+                    return true;
+                }
+            }
+            return energy >= minEnergy_;
+        }
+
+    private:
+
+        double minEnergy_;
+};
+
+/**
+ * @class PrimaryPDGFilter
+ * @brief Accepts events with a generator particle of a given PDG code, e.g. a signal A'
+ *
+ * @note All primary particles of all vertices are checked including their daughters.
+ */
+class PrimaryPDGFilter : public StoreFilter {
+
+    public:
+
+        PrimaryPDGFilter(int pdg) : pdg_(pdg) {
+        }
+
+        bool accept(const G4Event* anEvent) {
+            for (int i = 0; i < anEvent->GetNumberOfPrimaryVertex(); i++) {
+                if (hasPDG(anEvent->GetPrimaryVertex(i)->GetPrimary())) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+
+        bool hasPDG(G4PrimaryParticle* particle) {
+            for (; particle; particle = particle->GetNext()) {
+                if (particle->GetPDGcode() == pdg_ || hasPDG(particle->GetDaughter())) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+
+        int pdg_;
+};
+
+}
+
+#endif
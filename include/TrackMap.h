@@ -18,6 +18,11 @@
  */
 #include "Trajectory.h"
 
+/*
+ * C++
+ */
+#include <vector>
+
 namespace hpssim {
 
 /**
@@ -27,16 +32,23 @@ namespace hpssim {
  * @note
  * This class provides a record of track ancestry which is used
  * to connect track IDs to their parents.  It also maps track IDs
- * to Trajectory objects.
+ * to Trajectory objects.  Geant4 assigns track IDs sequentially
+ * within an event, so both maps are stored as vectors indexed
+ * directly by track ID.
  */
 class TrackMap {
 
     public:
 
         /**
-         * Map of track ID to parent ID.
+         * Dense list of parent IDs indexed by track ID.
+         */
+        typedef std::vector<G4int> TrackIDMap;
+
+        /**
+         * Dense list of Trajectory objects indexed by track ID.
          */
-        typedef std::map<G4int, G4int> TrackIDMap;
+        typedef std::vector<Trajectory*> TrajectoryVec;
 
         /**
          * Add a record in the map connecting a track ID to its parent ID.
@@ -44,6 +56,7 @@ class TrackMap {
          * @param parentID The parent track ID.
          */
         inline void addSecondary(G4int trackID, G4int parentID) {
+            reserve(trackID);
             trackIDMap_[trackID] = parentID;
         }
 
@@ -55,7 +68,7 @@ class TrackMap {
          * the first available Trajectory.
          */
         inline bool hasTrajectory(G4int trackID) {
-            return trajectoryMap_.find(trackID) != trajectoryMap_.end();
+            return inRange(trackID) && (trajectoryMap_[trackID] != nullptr || released_[trackID]);
         }
 
         /**
@@ -63,15 +76,37 @@ class TrackMap {
          * @param traj The Trajectory to add.
          */
         inline void addTrajectory(Trajectory* traj) {
+            reserve(traj->GetTrackID());
             trajectoryMap_[traj->GetTrackID()] = traj;
         }
 
+        /**
+         * Release the Trajectory of a track which has finished tracking.
+         * The track ID is still treated as having a trajectory when searching
+         * the parentage, but the Trajectory object is no longer referenced.
+         * @param trackID The track ID.
+         */
+        inline void releaseTrajectory(G4int trackID) {
+            if (inRange(trackID)) {
+                trajectoryMap_[trackID] = nullptr;
+                released_[trackID] = true;
+            }
+        }
+
         /**
          * Return true if the track ID is in the map.
          * @return True if the track ID is in the map.
          */
-        bool contains(G4int trackID) {
-            return trackIDMap_.find(trackID) != trackIDMap_.end();
+        inline bool contains(G4int trackID) {
+            return inRange(trackID) && trackIDMap_[trackID] != NO_PARENT;
+        }
+
+        /**
+         * Get the parent ID of a track.
+         * @return The parent track ID or -1 if the track ID is not in the map.
+         */
+        inline G4int getParentID(G4int trackID) {
+            return inRange(trackID) ? trackIDMap_[trackID] : NO_PARENT;
         }
 
         /**
@@ -81,11 +116,7 @@ class TrackMap {
          * track ID is not assigned to a Trajectory.
          */
         inline Trajectory* getTrajectory(G4int trackID) {
-            if (hasTrajectory(trackID)) {
-                return trajectoryMap_[trackID];
-            } else {
-                return nullptr;
-            }
+            return inRange(trackID) ? trajectoryMap_[trackID] : nullptr;
         }
 
         /**
@@ -94,38 +125,85 @@ class TrackMap {
          * first trajectory found in its parentage is returned.
          * @param anEvent The Geant4 event.
          * @param trackkID The track ID of the trajectory to find.
+         * @note Returns null if the first trajectory found has been released.
          */
         G4VTrajectory* findTrajectory(G4int trackID) {
-                G4int currTrackID = trackID;
-                G4VTrajectory* traj = nullptr;
-                for (;;) {
-                    traj = trajectoryMap_[currTrackID];
-                    if (traj) {
-                        break;
-                    } else {
-                        if (trackIDMap_.find(currTrackID) != trackIDMap_.end()) {
-                            currTrackID = trackIDMap_[currTrackID];
-                        } else {
-                            break;
-                        }
-                    }
+            G4int currTrackID = trackID;
+            while (inRange(currTrackID)) {
+                if (hasTrajectory(currTrackID)) {
+                    return trajectoryMap_[currTrackID];
                 }
-                return traj;
+                currTrackID = trackIDMap_[currTrackID];
             }
+            return nullptr;
+        }
 
+        /**
+         * Return true if this track or a track in its parentage has a trajectory,
+         * including trajectories which have been released.
+         * @param trackID The track ID.
+         */
+        bool hasTrajectoryInParentage(G4int trackID) {
+            G4int currTrackID = trackID;
+            while (inRange(currTrackID)) {
+                if (hasTrajectory(currTrackID)) {
+                    return true;
+                }
+                currTrackID = trackIDMap_[currTrackID];
+            }
+            return false;
+        }
+
+        /**
+         * Get one past the largest track ID that has been recorded in the map.
+         * @return One past the largest track ID in the map.
+         */
+        inline G4int size() {
+            return trackIDMap_.size();
+        }
+
+        /**
+         * Clear the map while keeping the allocated capacity for the next event.
+         */
         void clear() {
             trackIDMap_.clear();
             trajectoryMap_.clear();
+            released_.clear();
         }
 
+    private:
+
+        /**
+         * Return true if the track ID can be used to index the map.
+         */
+        inline bool inRange(G4int trackID) {
+            return trackID >= 0 && trackID < (G4int) trackIDMap_.size();
+        }
+
+        /**
+         * Grow the map so that the track ID can be used as an index.
+         */
+        inline void reserve(G4int trackID) {
+            if (trackID >= (G4int) trackIDMap_.size()) {
+                trackIDMap_.resize(trackID + 1, NO_PARENT);
+                trajectoryMap_.resize(trackID + 1, nullptr);
+                released_.resize(trackID + 1, false);
+            }
+        }
 
     private:
 
+        /** Marker for track IDs that have not been recorded in the map. */
+        enum { NO_PARENT = -1 };
+
         /** Map of track IDs to parent IDs. */
         TrackIDMap trackIDMap_;
 
         /** Map of track IDs to Trajectory objects. */
-        Trajectory::TrajectoryMap trajectoryMap_;
+        TrajectoryVec trajectoryMap_;
+
+        /** Flags for track IDs whose Trajectory has been released. */
+        std::vector<bool> released_;
 };
 
 }
@@ -2,16 +2,28 @@
 #define HPSSIM_USEREVENTACTION_H_
 
 #include "G4UserEventAction.hh"
+#include "G4EventManager.hh"
 
 #include "lcdd/detectors/CurrentTrackState.hh"
 
 #include "PluginManager.h"
+#include "Trajectory.h"
+#include "UserPrimaryParticleInformation.h"
+#include "UserTrackInformation.h"
 
 namespace hpssim {
 
 /**
  * @class UserEventAction
  * @brief Implementation of Geant4 user event action
+ *
+ * @note
+ * The per-event user objects (Trajectory, UserTrackInformation and
+ * UserPrimaryParticleInformation) are allocated from G4Allocator pools
+ * which keep their pages from one event to the next.  The number of
+ * pages is recorded at the beginning of every event so that any new
+ * heap allocation made by the pools during the event can be reported
+ * using <i>/event/verbose 2</i>.
  */
 class UserEventAction : public G4UserEventAction {
 
@@ -25,6 +37,16 @@ class UserEventAction : public G4UserEventAction {
             // Clear the global track map.
             UserTrackingAction::getUserTrackingAction()->getTrackMap()->clear();
 
+            // Clear MCParticles left over from an event that was not stored.
+            auto builder = UserTrackingAction::getUserTrackingAction()->getMCParticleBuilder();
+            if (builder) {
+                builder->clear();
+            }
+
+            // Reset the allocation counters of the per-event object pools.
+            trajectoryPages_ = TrajectoryAllocator.GetNoPages();
+            trackInfoPages_ = UserTrackInformationAllocator.GetNoPages();
+
             // Activate sim plugins.
             PluginManager::getPluginManager()->beginEvent(anEvent);
         }
@@ -37,7 +59,29 @@ class UserEventAction : public G4UserEventAction {
             // Cleanup gen event data if necessary.
             PrimaryGeneratorAction::getPrimaryGeneratorAction()->endEvent(anEvent);
 
+            // Print the number of pool pages that had to be allocated in this event.
+            if (G4EventManager::GetEventManager()->GetVerboseLevel() > 1) {
+                std::cout << "UserEventAction: Allocated "
+                        << (TrajectoryAllocator.GetNoPages() - trajectoryPages_) << " Trajectory, "
+                        << (UserTrackInformationAllocator.GetNoPages() - trackInfoPages_) << " UserTrackInformation and "
+                        << (UserPrimaryParticleInformationAllocator.GetNoPages() - primaryInfoPages_)
+                        << " UserPrimaryParticleInformation pool pages in event " << anEvent->GetEventID() << std::endl;
+            }
+
+            // Primaries are generated before the begin of event action so count them from here.
+            primaryInfoPages_ = UserPrimaryParticleInformationAllocator.GetNoPages();
         }
+
+    private:
+
+        /** Number of Trajectory pool pages at the beginning of the event. */
+        int trajectoryPages_{0};
+
+        /** Number of UserTrackInformation pool pages at the beginning of the event. */
+        int trackInfoPages_{0};
+
+        /** Number of UserPrimaryParticleInformation pool pages at the end of the previous event. */
+        int primaryInfoPages_{0};
 };
 }
 
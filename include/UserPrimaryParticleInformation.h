@@ -11,6 +11,8 @@
  * Geant4
  */
 #include "G4VUserPrimaryParticleInformation.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4Allocator.hh"
 
 namespace hpssim {
 
@@ -32,6 +34,18 @@ class UserPrimaryParticleInformation : public G4VUserPrimaryParticleInformation
          */
         virtual ~UserPrimaryParticleInformation() {;}
 
+        /**
+         * Create a new primary particle information object.
+         * @param s The size of the object.
+         */
+        inline void* operator new(size_t s);
+
+        /**
+         * Delete a primary particle information object.
+         * @param obj The object to delete.
+         */
+        inline void operator delete(void* obj);
+
         /**
          * Set the HEP event status (generator status) e.g. from an LHE particle.
          * @param hepEvtStatus The HEP event status.
@@ -66,6 +80,19 @@ class UserPrimaryParticleInformation : public G4VUserPrimaryParticleInformation
         int genStatus_{-1};
 };
 
+/**
+ * Custom memory allocator.
+ */
+extern G4Allocator<UserPrimaryParticleInformation> UserPrimaryParticleInformationAllocator;
+
+inline void* UserPrimaryParticleInformation::operator new(size_t) {
+    return (void*) UserPrimaryParticleInformationAllocator.MallocSingle();
+}
+
+inline void UserPrimaryParticleInformation::operator delete(void* info) {
+    UserPrimaryParticleInformationAllocator.FreeSingle((UserPrimaryParticleInformation*) info);
+}
+
 }
 
 #endif
@@ -30,9 +30,12 @@ class UserRunAction : public G4UserRunAction {
 
         void BeginOfRunAction(const G4Run* aRun) {
 
-            // init LCIO persistence engine
+            // init LCIO persistence engine, which also writes the columnar output if it is selected
             LcioPersistencyManager::getInstance()->Initialize();
 
+            // build the trajectory storage decisions from the geometry
+            UserTrackingAction::getUserTrackingAction()->initialize();
+
             // init the primary generators
             PrimaryGeneratorAction::getPrimaryGeneratorAction()->initialize();
 
@@ -8,6 +8,8 @@
 
 #include "G4VUserTrackInformation.hh"
 #include "G4ThreeVector.hh"
+#include "G4Allocator.hh"
+#include "G4Track.hh"
 
 #include "lcdd/core/VUserTrackInformation.hh"
 
@@ -27,6 +29,18 @@ class UserTrackInformation : public VUserTrackInformation {
         virtual ~UserTrackInformation() {
         }
 
+        /**
+         * Create a new track information object.
+         * @param s The size of the object.
+         */
+        inline void* operator new(size_t s);
+
+        /**
+         * Delete a track information object.
+         * @param obj The object to delete.
+         */
+        inline void operator delete(void* obj);
+
         static UserTrackInformation* getUserTrackInformation(const G4Track* aTrack) {
             return static_cast<UserTrackInformation*>(aTrack->GetUserInformation());
         }
@@ -95,6 +109,20 @@ class UserTrackInformation : public VUserTrackInformation {
 
         bool hasTrackerHit_{false};
 };
+
+/**
+ * Custom memory allocator.
+ */
+extern G4Allocator<UserTrackInformation> UserTrackInformationAllocator;
+
+inline void* UserTrackInformation::operator new(size_t) {
+    return (void*) UserTrackInformationAllocator.MallocSingle();
+}
+
+inline void UserTrackInformation::operator delete(void* info) {
+    UserTrackInformationAllocator.FreeSingle((UserTrackInformation*) info);
+}
+
 }
 
 #endif
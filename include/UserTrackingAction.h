@@ -7,6 +7,7 @@
 #include "G4UserTrackingAction.hh"
 #include "G4TrackingManager.hh"
 #include "G4RunManager.hh"
+#include "G4LogicalVolumeStore.hh"
 
 /*
  * LCDD
@@ -17,6 +18,7 @@
 /*
  * HPS
  */
+#include "MCParticleBuilder.h"
 #include "PluginManager.h"
 #include "TrackMap.h"
 #include "UserPrimaryParticleInformation.h"
@@ -63,7 +65,7 @@ class UserTrackingAction : public G4UserTrackingAction {
             //std::cout << "UserTrackingAction: post tracking - " << aTrack->GetTrackID() << std::endl;
 
             // Save extra trajectories on tracks that were flagged for saving during event processing.
-            auto info = dynamic_cast<UserTrackInformation*>(aTrack->GetUserInformation());
+            auto info = UserTrackInformation::getUserTrackInformation(aTrack);
 
             // Save tracks with tracker hits.
             // This flag is used by LCDD tracker detectors.
@@ -82,7 +84,8 @@ class UserTrackingAction : public G4UserTrackingAction {
             // Set end point momentum on the trajectory.
             if (fpTrackingManager->GetStoreTrajectory()) {
 
-                auto traj = dynamic_cast<Trajectory*>(fpTrackingManager->GimmeTrajectory());
+                // Only Trajectory objects are ever assigned to the tracking manager.
+                auto traj = Trajectory::getTrajectory(fpTrackingManager->GimmeTrajectory());
 
                 if (traj) {
 
@@ -92,10 +95,20 @@ class UserTrackingAction : public G4UserTrackingAction {
                     }
 
                     // Pass save flag from track info to the trajectory for persistency engine.
-                    bool saveFlag = UserTrackInformation::getUserTrackInformation(aTrack)->getSaveFlag();
+                    bool saveFlag = info->getSaveFlag();
                     //std::cout << "UserTrackingAction: Passing save flag " << saveFlag
                     //        << " to trajectory " << aTrack->GetTrackID() << std::endl;
                     traj->setSaveFlag(saveFlag);
+
+                    // In incremental mode, build the MCParticle of a finished track now and let the
+                    // tracking manager delete its trajectory instead of adding it to the event.
+                    if (builder_ && builder_->isIncremental() && isFinished(aTrack)) {
+                        if (saveFlag) {
+                            builder_->addTrajectory(traj);
+                        }
+                        trackMap_.releaseTrajectory(aTrack->GetTrackID());
+                        fpTrackingManager->SetStoreTrajectory(false);
+                    }
                 }
             }
 
@@ -118,8 +131,8 @@ class UserTrackingAction : public G4UserTrackingAction {
         void processTrack(const G4Track* aTrack) {
 
             // Setup the track info object.
-            UserTrackInformation* info = nullptr;
-            if (!aTrack->GetUserInformation()) {
+            UserTrackInformation* info = UserTrackInformation::getUserTrackInformation(aTrack);
+            if (!info) {
                 info = new UserTrackInformation;
                 info->setInitialMomentum(aTrack->GetMomentum());
                 const_cast<G4Track*>(aTrack)->SetUserInformation(info);
@@ -129,12 +142,11 @@ class UserTrackingAction : public G4UserTrackingAction {
              * Check if trajectory storage should be turned on.
              * Region is flagged for storing secondaries (e.g. "tracking region") or the particle is a primary.
              */
-            UserRegionInformation* regionInfo =
-                    (UserRegionInformation*) aTrack->GetLogicalVolumeAtVertex()->GetRegion()->GetUserInformation();
+            bool storeSecondaries = getStoreSecondaries(aTrack->GetLogicalVolumeAtVertex());
             bool isPrimary = (aTrack->GetDynamicParticle()->GetPrimaryParticle() != nullptr);
-            if ((regionInfo && regionInfo->getStoreSecondaries()) || isPrimary) {
+            if (storeSecondaries || isPrimary) {
                 /*
-                if (regionInfo && regionInfo->getStoreSecondaries()) {
+                if (storeSecondaries) {
                     std::cout << "UserTrackingAction: Storing trajectory for " << aTrack->GetTrackID() << " in region "
                             << aTrack->GetLogicalVolumeAtVertex()->GetRegion()->GetName()
                             << std::endl;
@@ -160,10 +172,44 @@ class UserTrackingAction : public G4UserTrackingAction {
             trackMap_.addSecondary(aTrack->GetTrackID(), aTrack->GetParentID());
         }
 
+        /**
+         * Build the table of trajectory storage decisions for every logical volume
+         * in the geometry from the region settings.
+         *
+         * @note This should be called at the beginning of the run after the geometry
+         * has been constructed.
+         */
+        void initialize() {
+            auto store = G4LogicalVolumeStore::GetInstance();
+            storeSecondaries_.clear();
+            for (auto lv : *store) {
+                G4int id = lv->GetInstanceID();
+                if (id >= (G4int) storeSecondaries_.size()) {
+                    storeSecondaries_.resize(id + 1, false);
+                }
+                storeSecondaries_[id] = isStoreSecondariesRegion(lv);
+            }
+        }
+
         TrackMap* getTrackMap() {
             return &trackMap_;
         }
 
+        /**
+         * Set the MCParticleBuilder which is used to build MCParticles
+         * at the end of tracking in incremental mode.
+         */
+        void setMCParticleBuilder(MCParticleBuilder* builder) {
+            builder_ = builder;
+        }
+
+        /**
+         * Get the MCParticleBuilder (may be null).
+         */
+        MCParticleBuilder* getMCParticleBuilder() {
+            return builder_;
+        }
+
         static UserTrackingAction* getUserTrackingAction() {
             return static_cast<UserTrackingAction*>(const_cast<G4UserTrackingAction*>(G4RunManager::GetRunManager()->GetUserTrackingAction()));
         }
@@ -172,9 +218,51 @@ class UserTrackingAction : public G4UserTrackingAction {
             return fpTrackingManager;
         }
 
+    private:
+
+        /**
+         * Return true if the track will not be tracked again in this event.
+         */
+        static bool isFinished(const G4Track* aTrack) {
+            G4TrackStatus status = aTrack->GetTrackStatus();
+            return status != fSuspend && status != fPostponeToNextEvent;
+        }
+
+        /**
+         * Get the cached decision for whether secondaries created in a logical volume
+         * should have their trajectories stored.
+         */
+        bool getStoreSecondaries(G4LogicalVolume* lv) {
+            G4int id = lv->GetInstanceID();
+            if (id < (G4int) storeSecondaries_.size()) {
+                return storeSecondaries_[id];
+            } else {
+                // Volume was created after the table was built.
+                return isStoreSecondariesRegion(lv);
+            }
+        }
+
+        /**
+         * Return true if the region of a logical volume is flagged for storing secondaries.
+         */
+        static bool isStoreSecondariesRegion(G4LogicalVolume* lv) {
+            auto region = lv->GetRegion();
+            if (region) {
+                auto regionInfo = static_cast<UserRegionInformation*>(region->GetUserInformation());
+                return regionInfo && regionInfo->getStoreSecondaries();
+            }
+            return false;
+        }
+
     private:
 
         TrackMap trackMap_;
+
+        /** Builder for MCParticles in incremental mode (not owned). */
+        MCParticleBuilder* builder_{nullptr};
+
+        /** Store secondaries decision indexed by logical volume instance ID. */
+        std::vector<bool> storeSecondaries_;
 };
 
 }
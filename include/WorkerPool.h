@@ -0,0 +1,150 @@
+#ifndef HPSSIM_WORKERPOOL_H_
+#define HPSSIM_WORKERPOOL_H_
+
+/*
+ * C++
+ */
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hpssim {
+
+/**
+ * @class WorkerPool
+ * @brief Persistent worker threads which run a batch of indexed tasks on request
+ *
+ * @note
+ * The workers are started once, e.g. at the beginning of a run, and wait on a
+ * condition variable until run() hands them a batch of tasks.  The calling
+ * thread works on the batch too and run() returns when all tasks are done.
+ * Tasks must not throw, because an exception cannot leave a worker thread.
+ */
+class WorkerPool {
+
+    public:
+
+        virtual ~WorkerPool() {
+            stop();
+        }
+
+        /**
+         * Start the worker threads, stopping the current ones first.
+         */
+        void start(int nWorkers) {
+            stop();
+            running_ = true;
+            for (int iWorker = 0; iWorker < nWorkers; iWorker++) {
+                workers_.push_back(std::thread(&WorkerPool::work, this));
+            }
+        }
+
+        /**
+         * Stop and join the worker threads.
+         */
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                running_ = false;
+            }
+            startCondition_.notify_all();
+            for (auto& worker : workers_) {
+                worker.join();
+            }
+            workers_.clear();
+        }
+
+        /**
+         * Get the number of worker threads, not counting the calling thread.
+         */
+        int getNumberOfWorkers() {
+            return workers_.size();
+        }
+
+        /**
+         * Run the task for each index from 0 to nTasks - 1 and wait until all are done.
+         */
+        void run(int nTasks, const std::function<void(int)>& task) {
+            if (workers_.empty()) {
+                for (int iTask = 0; iTask < nTasks; iTask++) {
+                    task(iTask);
+                }
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                task_ = &task;
+                nTasks_ = nTasks;
+                nextTask_ = 0;
+                nDone_ = 0;
+                ++batch_;
+            }
+            startCondition_.notify_all();
+            runTasks();
+            std::unique_lock<std::mutex> lock(mutex_);
+            doneCondition_.wait(lock, [this]() {return nDone_ == nTasks_;});
+            task_ = nullptr;
+        }
+
+    private:
+
+        void work() {
+            unsigned long batch = 0;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    startCondition_.wait(lock, [this, batch]() {return !running_ || batch_ != batch;});
+                    if (!running_) {
+                        return;
+                    }
+                    batch = batch_;
+                }
+                runTasks();
+            }
+        }
+
+        /**
+         * Take tasks of the current batch until none are left.
+         */
+        void runTasks() {
+            while (true) {
+                int iTask;
+                const std::function<void(int)>* task;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (nextTask_ >= nTasks_) {
+                        return;
+                    }
+                    iTask = nextTask_++;
+                    task = task_;
+                }
+                (*task)(iTask);
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (++nDone_ == nTasks_) {
+                    doneCondition_.notify_all();
+                }
+            }
+        }
+
+    private:
+
+        std::vector<std::thread> workers_;
+
+        std::mutex mutex_;
+        std::condition_variable startCondition_;
+        std::condition_variable doneCondition_;
+        bool running_{false};
+
+        /** The current batch of tasks. */
+        const std::function<void(int)>* task_{nullptr};
+        int nTasks_{0};
+        int nextTask_{0};
+        int nDone_{0};
+        unsigned long batch_{0};
+};
+
+}
+
+#endif
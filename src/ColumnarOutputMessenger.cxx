@@ -0,0 +1,47 @@
+#include "ColumnarOutputMessenger.h"
+
+#include "ColumnarOutput.h"
+
+namespace hpssim {
+
+ColumnarOutputMessenger::ColumnarOutputMessenger(ColumnarOutput* output) : output_(output) {
+
+    outputDir_ = new G4UIdirectory("/hps/output/", this);
+
+    formatCmd_ = new G4UIcmdWithAString("/hps/output/format", this);
+    formatCmd_->SetGuidance("Select the output format of the simulated events.");
+    formatCmd_->SetGuidance("The store filters and trigger apply to both formats, while merging, digitization");
+    formatCmd_->SetGuidance("and output streams are only supported with LCIO.");
+    formatCmd_->SetCandidates("lcio columnar");
+
+    columnarDir_ = new G4UIdirectory("/hps/output/columnar/", this);
+
+    fileCmd_ = new G4UIcmdWithAString("/hps/output/columnar/file", this);
+
+    verboseCmd_ = new G4UIcmdWithAnInteger("/hps/output/columnar/verbose", this);
+
+    chunkEventsCmd_ = new G4UIcmdWithAnInteger("/hps/output/columnar/chunkEvents", this);
+    chunkEventsCmd_->SetGuidance("Set the number of events per column chunk.");
+
+    compressionCmd_ = new G4UIcmdWithAnInteger("/hps/output/columnar/compression", this);
+    compressionCmd_->SetGuidance("Set the zlib compression level of the column chunks (0 for none).");
+    compressionCmd_->SetParameterName("level", false);
+    compressionCmd_->SetRange("level >= 0 && level <= 9");
+}
+
+void ColumnarOutputMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
+    if (command == formatCmd_) {
+        std::cout << "ColumnarOutputMessenger: Setting output format to '" << newValues << "'" << std::endl;
+        output_->setEnabled(newValues == "columnar");
+    } else if (command == fileCmd_) {
+        output_->setOutputFile(newValues);
+    } else if (command == verboseCmd_) {
+        output_->setVerbose(G4UIcmdWithAnInteger::GetNewIntValue(newValues));
+    } else if (command == chunkEventsCmd_) {
+        output_->setChunkEvents(G4UIcmdWithAnInteger::GetNewIntValue(newValues));
+    } else if (command == compressionCmd_) {
+        output_->setCompressionLevel(G4UIcmdWithAnInteger::GetNewIntValue(newValues));
+    }
+}
+
+}
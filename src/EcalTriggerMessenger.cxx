@@ -0,0 +1,106 @@
+#include "EcalTriggerMessenger.h"
+
+#include "EcalTriggerFilter.h"
+
+namespace hpssim {
+
+EcalTriggerMessenger::EcalTriggerMessenger(EcalTriggerFilter* trigger) : trigger_(trigger) {
+
+    triggerDir_ = new G4UIdirectory("/hps/lcio/filter/trigger/", this);
+    triggerDir_->SetGuidance("Emulate the ECal trigger and store only triggered events.");
+
+    enableCmd_ = new G4UIcmdWithABool("/hps/lcio/filter/trigger/enable", this);
+    enableCmd_->GetParameter(0)->SetOmittable(true);
+    enableCmd_->GetParameter(0)->SetDefaultValue("true");
+
+    verboseCmd_ = new G4UIcmdWithAnInteger("/hps/lcio/filter/trigger/verbose", this);
+
+    collectionCmd_ = new G4UIcmdWithAString("/hps/lcio/filter/trigger/collection", this);
+    collectionCmd_->SetGuidance("Set the calorimeter hits collection used by the trigger.");
+
+    modeCmd_ = new G4UIcmdWithAString("/hps/lcio/filter/trigger/mode", this);
+    modeCmd_->SetGuidance("Trigger on single clusters or on top and bottom cluster pairs.");
+    modeCmd_->SetCandidates("singles pair");
+
+    hitThresholdCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/lcio/filter/trigger/hitThreshold", this);
+    hitThresholdCmd_->SetGuidance("Minimum energy of hits used for clustering.");
+    hitThresholdCmd_->SetDefaultUnit("MeV");
+
+    seedThresholdCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/lcio/filter/trigger/seedThreshold", this);
+    seedThresholdCmd_->SetGuidance("Minimum energy of cluster seed hits.");
+    seedThresholdCmd_->SetDefaultUnit("MeV");
+
+    crystalPitchCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/lcio/filter/trigger/crystalPitch", this);
+    crystalPitchCmd_->SetGuidance("Distance between crystal centers used to find neighbouring hits.");
+    crystalPitchCmd_->SetDefaultUnit("mm");
+
+    clusterEnergyMinCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/lcio/filter/trigger/clusterEnergyMin", this);
+    clusterEnergyMinCmd_->SetDefaultUnit("MeV");
+
+    clusterEnergyMaxCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/lcio/filter/trigger/clusterEnergyMax", this);
+    clusterEnergyMaxCmd_->SetDefaultUnit("MeV");
+
+    clusterHitsMinCmd_ = new G4UIcmdWithAnInteger("/hps/lcio/filter/trigger/clusterHitsMin", this);
+
+    pairEnergySumMinCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/lcio/filter/trigger/pairEnergySumMin", this);
+    pairEnergySumMinCmd_->SetDefaultUnit("MeV");
+
+    pairEnergySumMaxCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/lcio/filter/trigger/pairEnergySumMax", this);
+    pairEnergySumMaxCmd_->SetDefaultUnit("MeV");
+
+    pairEnergyDiffMaxCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/lcio/filter/trigger/pairEnergyDiffMax", this);
+    pairEnergyDiffMaxCmd_->SetDefaultUnit("MeV");
+
+    pairCoplanarityMaxCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/lcio/filter/trigger/pairCoplanarityMax", this);
+    pairCoplanarityMaxCmd_->SetGuidance("Maximum deviation of the pair clusters from back to back around the beam axis.");
+    pairCoplanarityMaxCmd_->SetDefaultUnit("deg");
+
+    pairTimeMaxCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/lcio/filter/trigger/pairTimeMax", this);
+    pairTimeMaxCmd_->SetGuidance("Maximum time difference of the pair clusters; zero disables the cut.");
+    pairTimeMaxCmd_->SetDefaultUnit("ns");
+
+    prescaleCmd_ = new G4UIcmdWithAnInteger("/hps/lcio/filter/trigger/prescale", this);
+    prescaleCmd_->SetGuidance("Keep every Nth rejected event for validation; zero keeps none.");
+}
+
+void EcalTriggerMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
+    if (command == enableCmd_) {
+        trigger_->setEnabled(G4UIcmdWithABool::GetNewBoolValue(newValues));
+    } else if (command == verboseCmd_) {
+        trigger_->setVerbose(G4UIcmdWithAnInteger::GetNewIntValue(newValues));
+    } else if (command == collectionCmd_) {
+        trigger_->setCollectionName(newValues);
+    } else if (command == modeCmd_) {
+        if (newValues == "pair") {
+            trigger_->setTriggerMode(EcalTriggerFilter::PAIR);
+        } else {
+            trigger_->setTriggerMode(EcalTriggerFilter::SINGLES);
+        }
+    } else if (command == hitThresholdCmd_) {
+        trigger_->setHitThreshold(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
+    } else if (command == seedThresholdCmd_) {
+        trigger_->setSeedThreshold(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
+    } else if (command == crystalPitchCmd_) {
+        trigger_->setCrystalPitch(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
+    } else if (command == clusterEnergyMinCmd_) {
+        trigger_->setClusterEnergyMin(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
+    } else if (command == clusterEnergyMaxCmd_) {
+        trigger_->setClusterEnergyMax(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
+    } else if (command == clusterHitsMinCmd_) {
+        trigger_->setClusterHitsMin(G4UIcmdWithAnInteger::GetNewIntValue(newValues));
+    } else if (command == pairEnergySumMinCmd_) {
+        trigger_->setPairEnergySumMin(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
+    } else if (command == pairEnergySumMaxCmd_) {
+        trigger_->setPairEnergySumMax(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
+    } else if (command == pairEnergyDiffMaxCmd_) {
+        trigger_->setPairEnergyDiffMax(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
+    } else if (command == pairCoplanarityMaxCmd_) {
+        trigger_->setPairCoplanarityMax(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
+    } else if (command == pairTimeMaxCmd_) {
+        trigger_->setPairTimeMax(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
+    } else if (command == prescaleCmd_) {
+        trigger_->setPrescale(G4UIcmdWithAnInteger::GetNewIntValue(newValues));
+    }
+}
+
+}
@@ -0,0 +1,89 @@
+#include "LcioDigitizerMessenger.h"
+
+#include "LcioDigitizer.h"
+
+#include <sstream>
+
+namespace hpssim {
+
+LcioDigitizerMessenger::LcioDigitizerMessenger(LcioDigitizer* digitizer) : digitizer_(digitizer) {
+
+    digiDir_ = new G4UIdirectory("/hps/lcio/digi/", this);
+    digiDir_->SetGuidance("Digitize sim hit collections into readout-level collections before writing.");
+
+    trackerCmd_ = new G4UIcommand("/hps/lcio/digi/tracker", this);
+    trackerCmd_->SetGuidance("Digitize a SimTrackerHit collection into a TrackerData collection.");
+    auto p = new G4UIparameter("simCollection", 's', false);
+    trackerCmd_->SetParameter(p);
+    p = new G4UIparameter("digiCollection", 's', false);
+    trackerCmd_->SetParameter(p);
+
+    ecalCmd_ = new G4UIcommand("/hps/lcio/digi/ecal", this);
+    ecalCmd_->SetGuidance("Digitize a SimCalorimeterHit collection into a CalorimeterHit collection.");
+    p = new G4UIparameter("simCollection", 's', false);
+    ecalCmd_->SetParameter(p);
+    p = new G4UIparameter("digiCollection", 's', false);
+    ecalCmd_->SetParameter(p);
+
+    dropSimHitsCmd_ = new G4UIcmdWithABool("/hps/lcio/digi/dropSimHits", this);
+    dropSimHitsCmd_->SetGuidance("Write only the digitized collections instead of the sim hits they were made from.");
+    dropSimHitsCmd_->GetParameter(0)->SetOmittable(true);
+    dropSimHitsCmd_->GetParameter(0)->SetDefaultValue("true");
+
+    verboseCmd_ = new G4UIcmdWithAnInteger("/hps/lcio/digi/verbose", this);
+
+    trackerPairEnergyCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/lcio/digi/trackerPairEnergy", this);
+    trackerPairEnergyCmd_->SetGuidance("Energy needed to create one electron-hole pair in the tracker sensors.");
+    trackerPairEnergyCmd_->SetDefaultUnit("eV");
+
+    trackerNoiseCmd_ = new G4UIcmdWithADouble("/hps/lcio/digi/trackerNoise", this);
+    trackerNoiseCmd_->SetGuidance("Gaussian noise of the tracker charge in electrons.");
+
+    trackerThresholdCmd_ = new G4UIcmdWithADouble("/hps/lcio/digi/trackerThreshold", this);
+    trackerThresholdCmd_->SetGuidance("Minimum tracker charge in electrons.");
+
+    ecalNoiseCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/lcio/digi/ecalNoise", this);
+    ecalNoiseCmd_->SetGuidance("Gaussian noise of the calorimeter energy.");
+    ecalNoiseCmd_->SetDefaultUnit("MeV");
+
+    ecalThresholdCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/lcio/digi/ecalThreshold", this);
+    ecalThresholdCmd_->SetGuidance("Minimum integrated calorimeter energy.");
+    ecalThresholdCmd_->SetDefaultUnit("MeV");
+
+    ecalWindowCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/lcio/digi/ecalWindow", this);
+    ecalWindowCmd_->SetGuidance("Calorimeter integration window after the event time; zero integrates everything.");
+    ecalWindowCmd_->SetDefaultUnit("ns");
+}
+
+void LcioDigitizerMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
+    if (command == trackerCmd_ || command == ecalCmd_) {
+        std::stringstream ss(newValues);
+        std::string simCollName;
+        std::string digiCollName;
+        ss >> simCollName;
+        ss >> digiCollName;
+        if (command == trackerCmd_) {
+            digitizer_->addTrackerCollection(simCollName, digiCollName);
+        } else {
+            digitizer_->addEcalCollection(simCollName, digiCollName);
+        }
+    } else if (command == dropSimHitsCmd_) {
+        digitizer_->setDropSimHits(G4UIcmdWithABool::GetNewBoolValue(newValues));
+    } else if (command == verboseCmd_) {
+        digitizer_->setVerbose(G4UIcmdWithAnInteger::GetNewIntValue(newValues));
+    } else if (command == trackerPairEnergyCmd_) {
+        digitizer_->setTrackerPairEnergy(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
+    } else if (command == trackerNoiseCmd_) {
+        digitizer_->setTrackerNoise(G4UIcmdWithADouble::GetNewDoubleValue(newValues));
+    } else if (command == trackerThresholdCmd_) {
+        digitizer_->setTrackerThreshold(G4UIcmdWithADouble::GetNewDoubleValue(newValues));
+    } else if (command == ecalNoiseCmd_) {
+        digitizer_->setEcalNoise(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
+    } else if (command == ecalThresholdCmd_) {
+        digitizer_->setEcalThreshold(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
+    } else if (command == ecalWindowCmd_) {
+        digitizer_->setEcalWindow(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
+    }
+}
+
+}
@@ -0,0 +1,42 @@
+#include "LcioMergeJobMessenger.h"
+
+// include only in cxx file due to circular dep!
+#include "LcioMergeJob.h"
+
+namespace hpssim {
+
+LcioMergeJobMessenger::LcioMergeJobMessenger(LcioMergeJob* job) : job_(job) {
+
+    dir_ = new G4UIdirectory("/hps/merge/", this);
+
+    inputCmd_ = new G4UIcmdWithAString("/hps/merge/input", this);
+    inputCmd_->SetGuidance("Add an LCIO file from which base events are read.");
+
+    fileCmd_ = new G4UIcmdWithAString("/hps/merge/file", this);
+    fileCmd_->SetGuidance("Set the output LCIO file, which is recreated if it exists.");
+
+    neventsCmd_ = new G4UIcmdWithAnInteger("/hps/merge/nevents", this);
+    neventsCmd_->SetGuidance("Set the maximum number of events to write, or -1 for all base events.");
+
+    verboseCmd_ = new G4UIcmdWithAnInteger("/hps/merge/verbose", this);
+
+    lcioDir_ = new G4UIdirectory("/hps/lcio/", this);
+    mergeDir_ = new G4UIdirectory("/hps/lcio/merge/", this);
+    mergeAddCmd_ = new G4UIcmdWithAString("/hps/lcio/merge/add", this);
+}
+
+void LcioMergeJobMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
+    if (command == inputCmd_) {
+        job_->addInputFile(newValues);
+    } else if (command == fileCmd_) {
+        job_->setOutputFile(newValues);
+    } else if (command == neventsCmd_) {
+        job_->setMaxEvents(G4UIcmdWithAnInteger::GetNewIntValue(newValues));
+    } else if (command == verboseCmd_) {
+        job_->setVerbose(G4UIcmdWithAnInteger::GetNewIntValue(newValues));
+    } else if (command == mergeAddCmd_) {
+        job_->addMerge(new LcioMergeTool(newValues));
+    }
+}
+
+}
@@ -15,13 +15,46 @@ LcioMergeMessenger::LcioMergeMessenger(LcioMergeTool* merge) : merge_(merge) {
     G4String filePath = mergePath + "file";
     fileCmd_ = new G4UIcmdWithAString(filePath, this);
 
+    G4String collectionPath = mergePath + "collection";
+    collectionCmd_ = new G4UIcmdWithAString(collectionPath, this);
+    collectionCmd_->SetGuidance("Add a collection to merge; only these collections are read if any are set.");
+
+    G4String readCollectionPath = mergePath + "readCollection";
+    readCollectionCmd_ = new G4UIcmdWithAString(readCollectionPath, this);
+    readCollectionCmd_->SetGuidance("Add a collection to read without merging it, e.g. for filters.");
+
     G4String eventModulusPath = filterPath + "eventModulus";
     eventModulusFilterCmd_ = new G4UIcmdWithAnInteger(eventModulusPath, this);
 
     G4String combineCalHitsPath = mergePath + "combineCalHits";
     combineCalHitsCmd_ = new G4UIcmdWithABool(combineCalHitsPath, this);
+    combineCalHitsCmd_->SetGuidance("Combine merged SimCalorimeterHits with the same cell IDs into one hit.");
+    combineCalHitsCmd_->SetGuidance("LCRelation collections from or to SimCalorimeterHits are not merged when this is enabled.");
     combineCalHitsCmd_->SetDefaultValue(true);
 
+    G4String indexPath = mergePath + "index";
+    indexCmd_ = new G4UIcmdWithABool(indexPath, this);
+    indexCmd_->SetGuidance("Apply filters using a sidecar event index, which is built if it does not exist.");
+    indexCmd_->SetDefaultValue(true);
+
+    G4String indexDirPath = mergePath + "indexDir";
+    indexDirCmd_ = new G4UIcmdWithAString(indexDirPath, this);
+    indexDirCmd_->SetGuidance("Write and read the sidecar index files in this directory instead of next to the input files.");
+
+    G4String poolPath = mergePath + "pool";
+    poolCmd_ = new G4UIcmdWithAnInteger(poolPath, this);
+    poolCmd_->SetGuidance("Keep this many source events in memory and reuse them; zero disables the pool.");
+
+    G4String poolSamplingPath = mergePath + "poolSampling";
+    poolSamplingCmd_ = new G4UIcmdWithAString(poolSamplingPath, this);
+    poolSamplingCmd_->SetGuidance("Draw pooled events cyclically or randomly.");
+    poolSamplingCmd_->SetCandidates("cyclic random");
+
+    G4String poolReservoirPath = mergePath + "poolReservoir";
+    poolReservoirCmd_ = new G4UIcmdWithABool(poolReservoirPath, this);
+    poolReservoirCmd_->SetGuidance("Fill the pool by reservoir sampling over all events in the files.");
+    poolReservoirCmd_->SetDefaultValue(true);
+
     G4String ecalEnergyFilterPath = filterPath + "ecalEnergy";
     ecalEnergyFilterCmd_ = new G4UIcmdWithADoubleAndUnit(ecalEnergyFilterPath, this);
     ecalEnergyFilterCmd_->GetParameter(0)->SetOmittable(false);
@@ -32,6 +65,10 @@ LcioMergeMessenger::LcioMergeMessenger(LcioMergeTool* merge) : merge_(merge) {
 void LcioMergeMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
     if (command == fileCmd_) {
         merge_->addFile(newValues);
+    } else if (command == collectionCmd_) {
+        merge_->addCollection(newValues);
+    } else if (command == readCollectionCmd_) {
+        merge_->addReadCollection(newValues);
     } else if (command == eventModulusFilterCmd_) {
         auto filter = new LcioMergeTool::EventModulusFilter();
         auto modulus = G4UIcmdWithAnInteger::GetNewIntValue(newValues);
@@ -39,6 +76,20 @@ void LcioMergeMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
         merge_->addFilter(filter);
     } else if (command == combineCalHitsCmd_) {
         merge_->setCombineCalHits(G4UIcmdWithABool::GetNewBoolValue(newValues));
+    } else if (command == indexCmd_) {
+        merge_->setUseIndex(G4UIcmdWithABool::GetNewBoolValue(newValues));
+    } else if (command == indexDirCmd_) {
+        merge_->setIndexDirectory(newValues);
+    } else if (command == poolCmd_) {
+        merge_->setPoolSize(G4UIcmdWithAnInteger::GetNewIntValue(newValues));
+    } else if (command == poolSamplingCmd_) {
+        if (newValues == "random") {
+            merge_->setPoolSampling(LcioMergeTool::Random);
+        } else {
+            merge_->setPoolSampling(LcioMergeTool::Cyclic);
+        }
+    } else if (command == poolReservoirCmd_) {
+        merge_->setPoolReservoir(G4UIcmdWithABool::GetNewBoolValue(newValues));
     } else if (command == ecalEnergyFilterCmd_) {
         auto filter = new LcioMergeTool::EcalEnergyFilter();
         filter->setEnergyCut(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
@@ -0,0 +1,68 @@
+#include "LcioOutputStreamMessenger.h"
+
+#include "LcioOutputStream.h"
+
+#include <sstream>
+
+namespace hpssim {
+
+LcioOutputStreamMessenger::LcioOutputStreamMessenger(LcioOutputStream* stream) : stream_(stream) {
+
+    G4String streamPath = "/hps/lcio/stream/" + stream->getName() + "/";
+    streamDir_ = new G4UIdirectory(streamPath, this);
+
+    fileCmd_ = new G4UIcmdWithAString(streamPath + "file", this);
+
+    dropCmd_ = new G4UIcmdWithAString(streamPath + "drop", this);
+    dropCmd_->SetGuidance("Leave a collection out of the events written to this stream.");
+    dropCmd_->SetGuidance("Dropping MCParticle also drops the sim hit collections, which reference the MCParticles.");
+
+    primaryPDGCmd_ = new G4UIcmdWithAnInteger(streamPath + "primaryPDG", this);
+    primaryPDGCmd_->SetGuidance("Write only events with a generator particle of this PDG code.");
+
+    minHitsCmd_ = new G4UIcommand(streamPath + "minHits", this);
+    minHitsCmd_->SetGuidance("Write only events with at least this many hits in a hits collection.");
+    auto p = new G4UIparameter("collection", 's', false);
+    minHitsCmd_->SetParameter(p);
+    p = new G4UIparameter("hits", 'i', true);
+    p->SetDefaultValue(1);
+    minHitsCmd_->SetParameter(p);
+
+    minEnergyCmd_ = new G4UIcommand(streamPath + "minEnergy", this);
+    minEnergyCmd_->SetGuidance("Write only events with at least this energy in a calorimeter hits collection.");
+    p = new G4UIparameter("collection", 's', false);
+    minEnergyCmd_->SetParameter(p);
+    p = new G4UIparameter("energy", 'd', false);
+    minEnergyCmd_->SetParameter(p);
+    p = new G4UIparameter("unit", 's', true);
+    p->SetDefaultValue("MeV");
+    minEnergyCmd_->SetParameter(p);
+}
+
+void LcioOutputStreamMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
+    if (command == fileCmd_) {
+        stream_->setFileName(newValues);
+    } else if (command == dropCmd_) {
+        stream_->addDropCollection(newValues);
+    } else if (command == primaryPDGCmd_) {
+        stream_->addFilter(new PrimaryPDGFilter(G4UIcmdWithAnInteger::GetNewIntValue(newValues)));
+    } else if (command == minHitsCmd_) {
+        std::stringstream ss(newValues);
+        std::string collName;
+        int minHits;
+        ss >> collName;
+        ss >> minHits;
+        stream_->addFilter(new MinHitsFilter(collName, minHits));
+    } else if (command == minEnergyCmd_) {
+        std::stringstream ss(newValues);
+        std::string collName;
+        double minEnergy;
+        std::string unit;
+        ss >> collName;
+        ss >> minEnergy;
+        ss >> unit;
+        stream_->addFilter(new MinEnergyFilter(collName, minEnergy * G4UIcommand::ValueOf(unit.c_str())));
+    }
+}
+
+}
@@ -21,6 +21,11 @@ LcioPersistencyMessenger::LcioPersistencyMessenger(LcioPersistencyManager* mgr)
     appendCmd_ = new G4UIcommand("/hps/lcio/append", this);
     appendCmd_->SetGuidance("Append events to an existing LCIO file.");
 
+    compressionCmd_ = new G4UIcmdWithAnInteger("/hps/lcio/compression", this);
+    compressionCmd_->SetGuidance("Set the compression level of the output files from 0 (none) to 9 (best), or -1 for the LCIO default.");
+    compressionCmd_->SetParameterName("level", false);
+    compressionCmd_->SetRange("level >= -1 && level <= 9");
+
     mergeDir_ = new G4UIdirectory("/hps/lcio/merge/", this);
 
     mergeAddCmd_ = new G4UIcmdWithAString("/hps/lcio/merge/add", this);
@@ -42,6 +47,83 @@ LcioPersistencyMessenger::LcioPersistencyMessenger(LcioPersistencyManager* mgr)
     p = new G4UIparameter("skip", 'i', true);
     p->SetDefaultValue(0);
     dumpFileCmd_->SetParameter(p);
+
+    incrementalCmd_ = new G4UIcmdWithABool("/hps/lcio/incremental", this);
+    incrementalCmd_->SetGuidance("Build MCParticles at the end of tracking and delete trajectories right away.");
+    incrementalCmd_->GetParameter(0)->SetOmittable(true);
+    incrementalCmd_->GetParameter(0)->SetDefaultValue("true");
+
+    threadsCmd_ = new G4UIcmdWithAnInteger("/hps/lcio/threads", this);
+    threadsCmd_->SetGuidance("Set the number of threads used to convert hits collections to LCIO.");
+
+    recycleCmd_ = new G4UIcmdWithABool("/hps/lcio/recycle", this);
+    recycleCmd_->SetGuidance("Reuse LCIO collections, MCParticles and hits between events (not used when merging).");
+    recycleCmd_->GetParameter(0)->SetOmittable(true);
+    recycleCmd_->GetParameter(0)->SetDefaultValue("true");
+
+    sortOutputCmd_ = new G4UIcmdWithABool("/hps/lcio/sortOutput", this);
+    sortOutputCmd_->SetGuidance("Write MCParticles in depth-first ancestry order and hits sorted by cell ID and time.");
+    sortOutputCmd_->GetParameter(0)->SetOmittable(true);
+    sortOutputCmd_->GetParameter(0)->SetDefaultValue("true");
+
+    calContribCmd_ = new G4UIcmdWithAString("/hps/lcio/calContrib", this);
+    calContribCmd_->SetGuidance("Write one cal hit contribution per step (full) or one per MCParticle and PDG (compact).");
+    calContribCmd_->SetCandidates("full compact");
+
+    pruneDir_ = new G4UIdirectory("/hps/lcio/prune/", this);
+    pruneDir_->SetGuidance("Keep only MCParticles referenced by hits, their ancestors and generator particles.");
+
+    pruneEnableCmd_ = new G4UIcmdWithABool("/hps/lcio/prune/enable", this);
+    pruneEnableCmd_->GetParameter(0)->SetOmittable(true);
+    pruneEnableCmd_->GetParameter(0)->SetDefaultValue("true");
+
+    pruneMinEnergyCmd_ = new G4UIcmdWithADoubleAndUnit("/hps/lcio/prune/minEnergy", this);
+    pruneMinEnergyCmd_->SetGuidance("Minimum energy of MCParticles referenced by hits which are kept.");
+    pruneMinEnergyCmd_->SetDefaultUnit("MeV");
+
+    pruneKeepPDGCmd_ = new G4UIcmdWithAnInteger("/hps/lcio/prune/keepPDG", this);
+    pruneKeepPDGCmd_->SetGuidance("Keep MCParticles referenced by hits with this PDG code regardless of their energy.");
+
+    filterDir_ = new G4UIdirectory("/hps/lcio/filter/", this);
+    filterDir_->SetGuidance("Filters which are applied to the Geant4 hits before an event is written.");
+
+    filterMinHitsCmd_ = new G4UIcommand("/hps/lcio/filter/minHits", this);
+    filterMinHitsCmd_->SetGuidance("Store only events with at least this many hits in a hits collection.");
+    p = new G4UIparameter("collection", 's', false);
+    filterMinHitsCmd_->SetParameter(p);
+    p = new G4UIparameter("hits", 'i', true);
+    p->SetDefaultValue(1);
+    filterMinHitsCmd_->SetParameter(p);
+
+    filterMinEnergyCmd_ = new G4UIcommand("/hps/lcio/filter/minEnergy", this);
+    filterMinEnergyCmd_->SetGuidance("Store only events with at least this energy in a calorimeter hits collection.");
+    p = new G4UIparameter("collection", 's', false);
+    filterMinEnergyCmd_->SetParameter(p);
+    p = new G4UIparameter("energy", 'd', false);
+    filterMinEnergyCmd_->SetParameter(p);
+    p = new G4UIparameter("unit", 's', true);
+    p->SetDefaultValue("MeV");
+    filterMinEnergyCmd_->SetParameter(p);
+
+    filterClearCmd_ = new G4UIcommand("/hps/lcio/filter/clear", this);
+    filterClearCmd_->SetGuidance("Remove all store filters.");
+
+    rolloverDir_ = new G4UIdirectory("/hps/lcio/rollover/", this);
+    rolloverDir_->SetGuidance("Continue writing in numbered files like name_0001.slcio when a file is full.");
+
+    rolloverEventsCmd_ = new G4UIcmdWithAnInteger("/hps/lcio/rollover/events", this);
+    rolloverEventsCmd_->SetGuidance("Set the number of events per output file (0 for no limit).");
+
+    rolloverMegabytesCmd_ = new G4UIcmdWithAnInteger("/hps/lcio/rollover/megabytes", this);
+    rolloverMegabytesCmd_->SetGuidance("Set the size in MB after which a new output file is started (0 for no limit).");
+    rolloverMegabytesCmd_->SetGuidance("The size is read from the file on disk after each event while the writer may still");
+    rolloverMegabytesCmd_->SetGuidance("buffer data, so the limit is approximate and a file can exceed it by about one event.");
+
+    streamDir_ = new G4UIdirectory("/hps/lcio/stream/", this);
+    streamDir_->SetGuidance("Route events to additional output files by their content.");
+
+    streamAddCmd_ = new G4UIcmdWithAString("/hps/lcio/stream/add", this);
+    streamAddCmd_->SetGuidance("Add a named output stream; events go to the first stream that accepts them.");
 }
 
 void LcioPersistencyMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
@@ -72,6 +154,52 @@ void LcioPersistencyMessenger::SetNewValue(G4UIcommand* command, G4String newVal
         ss >> nevents;
         ss >> nskip;
         LcioPersistencyManager::dumpFile(fileName, nevents, nskip);
+    } else if (command == incrementalCmd_) {
+        mgr_->setIncremental(G4UIcmdWithABool::GetNewBoolValue(newValues));
+    } else if (command == threadsCmd_) {
+        mgr_->setConversionThreads(G4UIcmdWithAnInteger::GetNewIntValue(newValues));
+    } else if (command == recycleCmd_) {
+        mgr_->setRecycle(G4UIcmdWithABool::GetNewBoolValue(newValues));
+    } else if (command == sortOutputCmd_) {
+        mgr_->setSortOutput(G4UIcmdWithABool::GetNewBoolValue(newValues));
+    } else if (command == calContribCmd_) {
+        if (newValues == "compact") {
+            mgr_->setCalContribMode(LcioPersistencyManager::COMPACT);
+        } else {
+            mgr_->setCalContribMode(LcioPersistencyManager::FULL);
+        }
+    } else if (command == pruneEnableCmd_) {
+        mgr_->setPrune(G4UIcmdWithABool::GetNewBoolValue(newValues));
+    } else if (command == pruneMinEnergyCmd_) {
+        mgr_->setPruneMinEnergy(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValues));
+    } else if (command == pruneKeepPDGCmd_) {
+        mgr_->addPruneKeepPDG(G4UIcmdWithAnInteger::GetNewIntValue(newValues));
+    } else if (command == filterMinHitsCmd_) {
+        std::stringstream ss(newValues);
+        std::string collName;
+        int minHits;
+        ss >> collName;
+        ss >> minHits;
+        mgr_->addStoreFilter(new MinHitsFilter(collName, minHits));
+    } else if (command == filterMinEnergyCmd_) {
+        std::stringstream ss(newValues);
+        std::string collName;
+        double minEnergy;
+        std::string unit;
+        ss >> collName;
+        ss >> minEnergy;
+        ss >> unit;
+        mgr_->addStoreFilter(new MinEnergyFilter(collName, minEnergy * G4UIcommand::ValueOf(unit.c_str())));
+    } else if (command == filterClearCmd_) {
+        mgr_->clearStoreFilters();
+    } else if (command == rolloverEventsCmd_) {
+        mgr_->setRolloverEvents(G4UIcmdWithAnInteger::GetNewIntValue(newValues));
+    } else if (command == rolloverMegabytesCmd_) {
+        mgr_->setRolloverBytes(G4UIcmdWithAnInteger::GetNewIntValue(newValues) * 1024L * 1024L);
+    } else if (command == compressionCmd_) {
+        mgr_->setCompressionLevel(G4UIcmdWithAnInteger::GetNewIntValue(newValues));
+    } else if (command == streamAddCmd_) {
+        mgr_->addStream(new LcioOutputStream(newValues));
     }
 }
 
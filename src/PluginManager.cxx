@@ -70,6 +70,16 @@ void PluginManager::endEvent(const G4Event* event) {
     }
 }
 
+bool PluginManager::acceptEvent(const G4Event* event) {
+    auto& plugins = actions_[SimPlugin::FILTER];
+    for (PluginVec::iterator it = plugins.begin(); it != plugins.end(); it++) {
+        if (!(*it)->acceptEvent(event)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void PluginManager::generatePrimary(G4Event* event) {
     auto plugins = actions_[SimPlugin::PRIMARY];
     for (PluginVec::iterator it = plugins.begin(); it != plugins.end(); it++) {
@@ -58,6 +58,9 @@ PrimaryGeneratorMessenger::PrimaryGeneratorMessenger(PrimaryGenerator* generator
     randomCmd_ = new G4UIcommand(G4String(genDir + "random"), this);
 
     sequentialCmd_ = new G4UIcommand(G4String(genDir + "sequential"), this);
+
+    readCollectionCmd_ = new G4UIcmdWithAString(G4String(genDir + "readCollection"), this);
+    readCollectionCmd_->SetGuidance("Add a collection to read from the input files (LCIO only).");
 }
 
 PrimaryGeneratorMessenger::~PrimaryGeneratorMessenger() {
@@ -129,6 +132,8 @@ void PrimaryGeneratorMessenger::SetNewValue(G4UIcommand* command, G4String newVa
         generator_->setReadMode(PrimaryGenerator::Random);
     } else if (command == sequentialCmd_) {
         generator_->setReadMode(PrimaryGenerator::Sequential);
+    } else if (command == readCollectionCmd_) {
+        generator_->addReadCollection(newValues);
     }
 }
 
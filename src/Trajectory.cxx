@@ -37,7 +37,7 @@ Trajectory::Trajectory(const G4Track* aTrack) :
     */
 
     // Set initial momentum from track information.
-    UserTrackInformation* trackInfo = dynamic_cast<UserTrackInformation*>(aTrack->GetUserInformation());
+    UserTrackInformation* trackInfo = UserTrackInformation::getUserTrackInformation(aTrack);
     const G4ThreeVector& p = trackInfo->getInitialMomentum();
     initialMomentum_.set(p.x(), p.y(), p.z());
 
@@ -0,0 +1,7 @@
+#include "UserPrimaryParticleInformation.h"
+
+namespace hpssim {
+
+G4Allocator<UserPrimaryParticleInformation> UserPrimaryParticleInformationAllocator;
+
+}
@@ -0,0 +1,7 @@
+#include "UserTrackInformation.h"
+
+namespace hpssim {
+
+G4Allocator<UserTrackInformation> UserTrackInformationAllocator;
+
+}
@@ -0,0 +1,66 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "SioRecordStream.h"
+
+using namespace hpssim;
+
+void printUsage() {
+    std::cout << "Usage: hps-lcio-cat -o output.slcio [-r run] [-e firstEvent] [-s] [-q] input.slcio ..." << std::endl;
+    std::cout << "  -r  write this run number into all run and event headers" << std::endl;
+    std::cout << "  -e  renumber events sequentially starting from this number" << std::endl;
+    std::cout << "  -s  write only the first run header" << std::endl;
+    std::cout << "  -q  do not print progress" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+
+    SioRecordCat cat;
+    std::string outputFile;
+    std::vector<std::string> inputFiles;
+
+    for (int iArg = 1; iArg < argc; iArg++) {
+        std::string arg = argv[iArg];
+        bool hasValue = iArg + 1 < argc;
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if (arg == "-o" && hasValue) {
+            outputFile = argv[++iArg];
+        } else if (arg == "-r" && hasValue) {
+            cat.setRunNumber(std::atoi(argv[++iArg]));
+        } else if (arg == "-e" && hasValue) {
+            cat.setFirstEventNumber(std::atoi(argv[++iArg]));
+        } else if (arg == "-s") {
+            cat.setSingleRunHeader(true);
+        } else if (arg == "-q") {
+            cat.setVerbose(0);
+        } else if (arg[0] == '-') {
+            std::cerr << "hps-lcio-cat: Bad argument: " << arg << std::endl;
+            printUsage();
+            return 1;
+        } else {
+            inputFiles.push_back(arg);
+        }
+    }
+
+    if (outputFile.empty() || inputFiles.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    try {
+        cat.open(outputFile);
+        for (auto& inputFile : inputFiles) {
+            cat.add(inputFile);
+        }
+        cat.close();
+    } catch (std::exception& e) {
+        std::cerr << "hps-lcio-cat: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
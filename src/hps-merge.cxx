@@ -0,0 +1,72 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "G4UImanager.hh"
+
+#include "LcioMergeJob.h"
+
+using namespace hpssim;
+
+void printUsage() {
+    std::cout << "Usage: hps-merge [-i input.slcio] [-o output.slcio] [-n nevents] [-v verbose]"
+            << " [-c command] [macro.mac] ..." << std::endl;
+    std::cout << "  Options and macros are applied in order, and merge streams are configured"
+            << " using the /hps/lcio/merge/ commands." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+
+    std::cout << "Hello hps-merge!" << std::endl;
+
+    if (argc == 1) {
+        printUsage();
+        return 1;
+    }
+
+    LcioMergeJob* job = new LcioMergeJob();
+
+    G4UImanager* UImgr = G4UImanager::GetUIpointer();
+
+    for (int iArg = 1; iArg < argc; iArg++) {
+        std::string arg = argv[iArg];
+        bool hasValue = iArg + 1 < argc;
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            delete job;
+            return 0;
+        } else if (arg == "-i" && hasValue) {
+            job->addInputFile(argv[++iArg]);
+        } else if (arg == "-o" && hasValue) {
+            job->setOutputFile(argv[++iArg]);
+        } else if (arg == "-n" && hasValue) {
+            job->setMaxEvents(std::atoi(argv[++iArg]));
+        } else if (arg == "-v" && hasValue) {
+            job->setVerbose(std::atoi(argv[++iArg]));
+        } else if (arg == "-c" && hasValue) {
+            if (UImgr->ApplyCommand(argv[++iArg])) {
+                std::cerr << "hps-merge: Command failed: " << argv[iArg] << std::endl;
+                delete job;
+                return 1;
+            }
+        } else if (arg[0] == '-') {
+            std::cerr << "hps-merge: Bad argument: " << arg << std::endl;
+            printUsage();
+            delete job;
+            return 1;
+        } else {
+            std::cout << "Executing macro " << arg << " ..." << std::endl;
+            if (UImgr->ApplyCommand("/control/execute " + arg)) {
+                std::cerr << "hps-merge: Macro failed: " << arg << std::endl;
+                delete job;
+                return 1;
+            }
+        }
+    }
+
+    job->run();
+
+    delete job;
+
+    std::cout << "Bye hps-merge!" << std::endl;
+}
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <string>
 
 #include "FTFP_BERT.hh"
 #include "G4RunManager.hh"
@@ -10,6 +11,7 @@
 #include "lcdd/core/LCDDDetectorConstruction.hh"
 
 #include "SteppingAction.h"
+#include "EmPhysicsList.h"
 #include "LcioPersistencyManager.h"
 #include "PluginManager.h"
 #include "PrimaryGeneratorAction.h"
@@ -20,13 +22,66 @@
 
 using namespace hpssim;
 
+void printUsage() {
+    std::cout << "Usage: hps-sim [-p physics] [--gamma-nuclear] [macro.mac]" << std::endl;
+    std::cout << "  The physics list is FTFP_BERT (default), em-opt0 (or em-only) or em-opt4."
+            << "  Without a macro an interactive session is started." << std::endl;
+}
+
+/**
+ * Create the physics list by name, or return null if the name is not known.
+ */
+G4VUserPhysicsList* createPhysicsList(const std::string& name, bool gammaNuclear) {
+    if (name == "FTFP_BERT") {
+        return new FTFP_BERT;
+    } else if (name == "em-opt0" || name == "em-only") {
+        return new EmPhysicsList(0, gammaNuclear);
+    } else if (name == "em-opt4") {
+        return new EmPhysicsList(4, gammaNuclear);
+    }
+    return nullptr;
+}
+
 int main(int argc, char* argv[]) {
 
     std::cout << "Hello hps-sim!" << std::endl;
 
+    std::string physicsName = "FTFP_BERT";
+    bool gammaNuclear = false;
+    std::string macroFile;
+    for (int iArg = 1; iArg < argc; iArg++) {
+        std::string arg = argv[iArg];
+        bool hasValue = iArg + 1 < argc;
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if ((arg == "-p" || arg == "--physics") && hasValue) {
+            physicsName = argv[++iArg];
+        } else if (arg == "--gamma-nuclear") {
+            gammaNuclear = true;
+        } else if (arg[0] == '-' || macroFile.size()) {
+            std::cerr << "hps-sim: Bad argument: " << arg << std::endl;
+            printUsage();
+            return 1;
+        } else {
+            macroFile = arg;
+        }
+    }
+
+    G4VUserPhysicsList* physicsList = createPhysicsList(physicsName, gammaNuclear);
+    if (!physicsList) {
+        std::cerr << "hps-sim: Unknown physics list: " << physicsName << std::endl;
+        printUsage();
+        return 1;
+    }
+    if (gammaNuclear && physicsName == "FTFP_BERT") {
+        std::cout << "hps-sim: Gamma-nuclear reactions are always included in FTFP_BERT" << std::endl;
+    }
+    std::cout << "Using physics list " << physicsName << (gammaNuclear ? " with gamma-nuclear" : "") << std::endl;
+
     G4UIExecutive* UIExec = 0;
-    if (argc == 1) {
-        UIExec = new G4UIExecutive(argc, argv);
+    if (macroFile.empty()) {
+        UIExec = new G4UIExecutive(1, argv);
     }
 
     G4RunManager* mgr = new G4RunManager();
@@ -36,7 +91,7 @@ int main(int argc, char* argv[]) {
     LCDDDetectorConstruction* det = new LCDDDetectorConstruction();
 
     mgr->SetUserInitialization(det);
-    mgr->SetUserInitialization(new FTFP_BERT);
+    mgr->SetUserInitialization(physicsList);
     mgr->SetUserAction(new PrimaryGeneratorAction);
     mgr->SetUserAction(new UserTrackingAction);
     mgr->SetUserAction(new UserRunAction);
@@ -53,7 +108,7 @@ int main(int argc, char* argv[]) {
 
     if (UIExec == 0) {
         G4String command = "/control/execute ";
-        G4String fileName = argv[1];
+        G4String fileName = macroFile;
         std::cout << "Executing macro " << fileName << " ..." << std::endl;
         UImgr->ApplyCommand(command + fileName);
     } else {